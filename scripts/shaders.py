@@ -4,6 +4,8 @@ def build_shaders(cwd, build_dir):
     shaders = [
         ("src/scene/shader/render.frag.glsl", "scene_render_frag", "frag"),
         ("src/scene/shader/render.vert.glsl", "scene_render_vert", "vert"),
+        ("src/scene/shader/blur-down.comp.glsl", "scene_blur_down", "comp"),
+        ("src/scene/shader/blur-up.comp.glsl",   "scene_blur_up",   "comp"),
     ]
 
     shader_gen_dir         = ensure_dir(build_dir / "shaders")
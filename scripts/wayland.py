@@ -22,6 +22,7 @@ def list_wayland_protocols(deps):
     add(system_protocol_dir / "unstable/pointer-constraints/pointer-constraints-unstable-v1.xml")
 
     add(deps["kde-protocols"] / "src/protocols/server-decoration.xml")
+    add(deps["kde-protocols"] / "src/protocols/blur.xml")
 
     return wayland_protocols
 
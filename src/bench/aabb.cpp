@@ -0,0 +1,82 @@
+#include "bench.hpp"
+
+#include <core/math.hpp>
+
+static constexpr u32 bench_aabb_points = 1024;
+
+// Plain loops over the boxes, matching the fallback paths of `aabbs_find_point` and `aabbs_clamp_point`
+
+static
+auto find_point_scalar(std::span<const aabb2f32> aabbs, vec2f32 point) -> usz
+{
+    for (usz i = 0; i < aabbs.size(); ++i) {
+        if (aabb_contains(aabbs[i], point)) return i;
+    }
+    return aabbs.size();
+}
+
+static
+auto clamp_point_scalar(std::span<const aabb2f32> aabbs, vec2f32 point) -> vec2f32
+{
+    f64 closest_dist = INFINITY;
+    vec2f32 closest = point;
+    for (auto& aabb : aabbs) {
+        auto pos = aabb_clamp_point(aabb, point);
+        auto d = vec_cast<f64>(pos) - vec_cast<f64>(point);
+        f64 dist = d.x * d.x + d.y * d.y;
+        if (dist < closest_dist) {
+            closest = pos;
+            closest_dist = dist;
+        }
+    }
+    return closest;
+}
+
+void bench_aabb()
+{
+#if !defined(__SSE2__)
+    log_warn("SSE2 is not available, batched queries use the scalar fallback");
+#endif
+
+    std::minstd_rand rng(1);
+    std::uniform_real_distribution<f32> pos(0.f, 3840.f);
+    std::uniform_real_distribution<f32> size(16.f, 256.f);
+
+    std::vector<vec2f32> points;
+    for (u32 i = 0; i < bench_aabb_points; ++i) {
+        points.push_back({pos(rng), pos(rng)});
+    }
+
+    for (u32 count : {4, 16, 64}) {
+        std::vector<aabb2f32> aabbs;
+        for (u32 i = 0; i < count; ++i) {
+            aabbs.push_back({{pos(rng), pos(rng)}, {size(rng), size(rng)}, xywh});
+        }
+
+        // Most points miss every box, so finds usually scan the whole span
+
+        bench_run(std::format("aabbs find x{} in {} (scalar)", bench_aabb_points, count), [&] {
+            usz hits = 0;
+            for (auto point : points) hits += find_point_scalar(aabbs, point);
+            bench_keep(hits);
+        });
+
+        bench_run(std::format("aabbs find x{} in {} (batched)", bench_aabb_points, count), [&] {
+            usz hits = 0;
+            for (auto point : points) hits += aabbs_find_point<f32>(aabbs, point);
+            bench_keep(hits);
+        });
+
+        bench_run(std::format("aabbs clamp x{} in {} (scalar)", bench_aabb_points, count), [&] {
+            vec2f32 sum = {};
+            for (auto point : points) sum += clamp_point_scalar(aabbs, point);
+            bench_keep(sum);
+        });
+
+        bench_run(std::format("aabbs clamp x{} in {} (batched)", bench_aabb_points, count), [&] {
+            vec2f32 sum = {};
+            for (auto point : points) sum += aabbs_clamp_point<f32>(aabbs, point);
+            bench_keep(sum);
+        });
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <core/log.hpp>
+#include <core/types.hpp>
+
+// Minimum time spent repeating each benchmark, after one untimed warm-up call
+static constexpr auto bench_min_duration = 250ms;
+
+// Prevents the compiler from discarding `value`, or the work that produced it
+template<typename T>
+void bench_keep(const T& value)
+{
+    asm volatile("" :: "r"(&value) : "memory");
+}
+
+/**
+ * Repeats `fn` for at least `bench_min_duration` and logs the mean time per call.
+ * Each call should do enough work to dwarf the cost of reading the clock.
+ */
+template<typename Fn>
+void bench_run(std::string_view name, Fn&& fn)
+{
+    fn();
+
+    u64 iterations = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::nanoseconds elapsed;
+    do {
+        fn();
+        iterations++;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < bench_min_duration);
+
+    log_info("{:<48} {:>12.1f} us", name, std::chrono::duration<f64, std::micro>(elapsed).count() / iterations);
+}
+
+void bench_scene();
+void bench_region();
+void bench_aabb();
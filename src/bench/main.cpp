@@ -0,0 +1,17 @@
+#include "bench.hpp"
+
+#include <core/object.hpp>
+
+auto main() -> int
+{
+    log_init("bench.log");
+    registry_init();
+    defer {
+        registry_deinit();
+        log_deinit();
+    };
+
+    bench_scene();
+    bench_region();
+    bench_aabb();
+}
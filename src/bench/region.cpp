@@ -0,0 +1,89 @@
+#include "bench.hpp"
+
+#include <core/region.hpp>
+
+static constexpr u32 bench_region_points = 1024;
+
+// Overlapping window-sized boxes scattered over a 4k output, with a fixed seed so runs are comparable
+static
+auto create_boxes(u32 count, u32 seed) -> std::vector<aabb2f32>
+{
+    std::minstd_rand rng(seed);
+    std::uniform_real_distribution<f32> pos(0.f, 3840.f);
+    std::uniform_real_distribution<f32> size(16.f, 640.f);
+
+    std::vector<aabb2f32> boxes;
+    for (u32 i = 0; i < count; ++i) {
+        boxes.push_back({{std::floor(pos(rng)), std::floor(pos(rng))}, {std::floor(size(rng)), std::floor(size(rng))}, xywh});
+    }
+    return boxes;
+}
+
+static
+auto create_region(std::span<const aabb2f32> boxes) -> region2f32
+{
+    region2f32 region;
+    for (auto& box : boxes) region.add(box);
+    return region;
+}
+
+static
+auto create_points(u32 seed) -> std::vector<vec2f32>
+{
+    std::minstd_rand rng(seed);
+    std::uniform_real_distribution<f32> pos(0.f, 4480.f);
+
+    std::vector<vec2f32> points;
+    for (u32 i = 0; i < bench_region_points; ++i) {
+        points.push_back({pos(rng), pos(rng)});
+    }
+    return points;
+}
+
+void bench_region()
+{
+    auto boxes = create_boxes(64, 1);
+    auto other = create_region(create_boxes(64, 2));
+    auto points = create_points(3);
+
+    auto region = create_region(boxes);
+    log_info("region of {} boxes, holding {} rectangles", boxes.size(), region.aabbs.size());
+
+    bench_run("region add 64 boxes", [&] {
+        bench_keep(create_region(boxes));
+    });
+
+    bench_run("region subtract region", [&] {
+        auto copy = region;
+        copy.subtract(other);
+        bench_keep(copy);
+    });
+
+    bench_run("region intersect region", [&] {
+        auto copy = region;
+        copy.intersect(other);
+        bench_keep(copy);
+    });
+
+    // Point queries, against regions below and above the scanning threshold
+
+    auto small = create_region(std::span(boxes).first(4));
+    log_info("small region holding {} rectangles", small.aabbs.size());
+
+    auto query = [&](const region2f32* target) {
+        return [&points, target] {
+            u32 hits = 0;
+            for (auto point : points) hits += target->contains(point);
+            bench_keep(hits);
+        };
+    };
+
+    bench_run(std::format("region contains x{} (small)", bench_region_points), query(&small));
+    bench_run(std::format("region contains x{} (large)", bench_region_points), query(&region));
+
+    bench_run(std::format("region constrain x{} (large)", bench_region_points), [&] {
+        vec2f32 sum = {};
+        for (auto point : points) sum += region.constrain(point);
+        bench_keep(sum);
+    });
+}
@@ -0,0 +1,74 @@
+#include "bench.hpp"
+
+#include <scene/scene.hpp>
+
+static constexpr u32 bench_scene_trees  = 1000;
+static constexpr u32 bench_scene_leaves = 9; // Per tree, for 10k nodes in total
+
+// A flat layer of window-like trees, each holding a mix of textures, meshes and input regions
+static
+auto create_scene(RefVector<SceneNode>& nodes) -> Ref<SceneTree>
+{
+    auto root = scene_tree_create();
+    for (u32 i = 0; i < bench_scene_trees; ++i) {
+        auto tree = scene_tree_create();
+        scene_tree_set_translation(tree.get(), {f32(i % 40) * 48.f, f32(i / 40) * 48.f});
+        scene_tree_place_above(root.get(), nullptr, tree.get());
+
+        for (u32 j = 0; j < bench_scene_leaves; ++j) {
+            SceneNode* leaf = nullptr;
+            switch (j % 3) {
+                break;case 0: leaf = nodes.emplace_back(scene_texture_create().get());
+                break;case 1: leaf = nodes.emplace_back(scene_mesh_create().get());
+                break;case 2: leaf = nodes.emplace_back(scene_input_region_create().get());
+            }
+            scene_tree_place_above(tree.get(), nullptr, leaf);
+        }
+
+        nodes.emplace_back(tree.get());
+    }
+    return root;
+}
+
+void bench_scene()
+{
+    RefVector<SceneNode> nodes;
+    auto root = create_scene(nodes);
+
+    // Visits every node and downcasts leaves, as rendering and damage collection do
+
+    bench_run("scene iterate 10k (type tag)", [&] {
+        u32 textures = 0;
+        scene_iterate<SceneIterateDirection::back_to_front>(root.get(),
+            scene_iterate_default,
+            [&](SceneNode* node) { if (scene_node_cast<SceneTexture>(node)) textures++; },
+            scene_iterate_default);
+        bench_keep(textures);
+    });
+
+    bench_run("scene iterate 10k (dynamic_cast)", [&] {
+        u32 textures = 0;
+        scene_iterate<SceneIterateDirection::back_to_front>(root.get(),
+            scene_iterate_default,
+            [&](SceneNode* node) { if (dynamic_cast<SceneTexture*>(node)) textures++; },
+            scene_iterate_default);
+        bench_keep(textures);
+    });
+
+    // Moving the root invalidates every cached world position
+
+    f32 offset = 0.f;
+    bench_run("scene world positions 10k (after move)", [&] {
+        scene_tree_set_translation(root.get(), {offset, 0.f});
+        offset = offset ? 0.f : 1.f;
+
+        vec2f32 sum = {};
+        scene_iterate<SceneIterateDirection::back_to_front>(root.get(),
+            scene_iterate_default,
+            [&](SceneNode* node) { sum += scene_tree_get_position(node->parent); },
+            scene_iterate_default);
+        bench_keep(sum);
+    });
+
+    scene_tree_clear(root.get());
+}
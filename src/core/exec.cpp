@@ -164,3 +164,54 @@ void fd_unlisten(ExecContext* exec, fd_t fd)
 
     exec->listeners[fd] = nullptr;
 }
+
+// -----------------------------------------------------------------------------
+
+struct ExecTimer
+{
+    ExecContext* exec;
+    Fd fd;
+
+    std::move_only_function<void()> callback;
+
+    ~ExecTimer();
+};
+
+auto exec_timer_create(ExecContext* exec, std::move_only_function<void()> callback) -> Ref<ExecTimer>
+{
+    auto timer = ref_create<ExecTimer>();
+    timer->exec = exec;
+    timer->callback = std::move(callback);
+    timer->fd = Fd(unix_check<timerfd_create>(steady_clock_id, TFD_NONBLOCK | TFD_CLOEXEC).value);
+
+    fd_listen(exec, timer->fd.get(), FdEventBit::readable, [timer = timer.get()](fd_t fd, Flags<FdEventBit>) {
+        u64 expirations;
+        if (unix_check<read, EAGAIN>(fd, &expirations, sizeof(expirations)).ok()) {
+            timer->callback();
+        }
+    });
+
+    return timer;
+}
+
+ExecTimer::~ExecTimer()
+{
+    fd_unlisten(exec, fd.get());
+}
+
+void exec_timer_set(ExecTimer* timer, std::chrono::steady_clock::time_point time)
+{
+    auto value = steady_clock_to_timespec<steady_clock_id>(time);
+
+    // A zero value disarms the timer, so fire as soon as possible instead
+    if (!value.tv_sec && !value.tv_nsec) value.tv_nsec = 1;
+
+    unix_check<timerfd_settime>(timer->fd.get(), TFD_TIMER_ABSTIME, ptr_to(itimerspec {
+        .it_value = value,
+    }), nullptr);
+}
+
+void exec_timer_cancel(ExecTimer* timer)
+{
+    unix_check<timerfd_settime>(timer->fd.get(), TFD_TIMER_ABSTIME, ptr_to(itimerspec {}), nullptr);
+}
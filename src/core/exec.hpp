@@ -85,3 +85,16 @@ void fd_listen(
     fd_listen(exec, fd, listener.get());
 }
 
+
+// -----------------------------------------------------------------------------
+
+/**
+ * A one-shot timer on the steady clock, backed by a timerfd.
+ */
+struct ExecTimer;
+
+auto exec_timer_create(ExecContext*, std::move_only_function<void()> callback) -> Ref<ExecTimer>;
+
+// Schedules the callback for `time`, replacing any previously scheduled time
+void exec_timer_set(   ExecTimer*, std::chrono::steady_clock::time_point time);
+void exec_timer_cancel(ExecTimer*);
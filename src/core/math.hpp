@@ -39,6 +39,7 @@ template<typename To, typename From> constexpr auto vec_cast(Vec<4, From> v) ->
 
 template<typename T> constexpr auto vec_abs(  Vec<2, T> v) -> Vec<2, T> { return { std::abs(  v.x), std::abs(  v.y) }; }
 template<typename T> constexpr auto vec_floor(Vec<2, T> v) -> Vec<2, T> { return { std::floor(v.x), std::floor(v.y) }; }
+template<typename T> constexpr auto vec_ceil( Vec<2, T> v) -> Vec<2, T> { return { std::ceil( v.x), std::ceil( v.y) }; }
 template<typename T> constexpr auto vec_round(Vec<2, T> v) -> Vec<2, T> { return { std::round(v.x), std::round(v.y) }; }
 
 // -----------------------------------------------------------------------------
@@ -213,6 +214,117 @@ auto aabb_subtract(const Aabb<T>& minuend, const Aabb<T>& subtrahend, Aabb<T>* o
 
 // -----------------------------------------------------------------------------
 
+#if defined(__SSE2__)
+namespace detail
+{
+    static_assert(sizeof(aabb2f32) == 4 * sizeof(f32));
+
+    // Loads four consecutive boxes, transposed into one register per component
+    struct Aabb4f32
+    {
+        __m128 min_x, min_y, max_x, max_y;
+
+        Aabb4f32(const aabb2f32* aabbs)
+        {
+            auto* data = reinterpret_cast<const f32*>(aabbs);
+            min_x = _mm_loadu_ps(data);
+            min_y = _mm_loadu_ps(data + 4);
+            max_x = _mm_loadu_ps(data + 8);
+            max_y = _mm_loadu_ps(data + 12);
+            _MM_TRANSPOSE4_PS(min_x, min_y, max_x, max_y);
+        }
+    };
+}
+#endif
+
+/**
+ * Returns the index of the first box in `aabbs` that contains `point`, or `aabbs.size()` if none do.
+ */
+template<typename T>
+auto aabbs_find_point(std::span<const Aabb<T>> aabbs, Vec<2, T> point) -> usz
+{
+    usz i = 0;
+
+#if defined(__SSE2__)
+    if constexpr (std::same_as<T, f32>) {
+        auto x = _mm_set1_ps(point.x);
+        auto y = _mm_set1_ps(point.y);
+        for (; i + 4 <= aabbs.size(); i += 4) {
+            detail::Aabb4f32 box(aabbs.data() + i);
+            auto inside = _mm_and_ps(
+                _mm_and_ps(_mm_cmple_ps(box.min_x, x), _mm_cmplt_ps(x, box.max_x)),
+                _mm_and_ps(_mm_cmple_ps(box.min_y, y), _mm_cmplt_ps(y, box.max_y)));
+            if (u32 mask = _mm_movemask_ps(inside)) return i + std::countr_zero(mask);
+        }
+    }
+#endif
+
+    for (; i < aabbs.size(); ++i) {
+        if (aabb_contains<T>(aabbs[i], point)) return i;
+    }
+    return aabbs.size();
+}
+
+/**
+ * Returns the point within any of `aabbs` that is closest to `point`, or `point` if `aabbs` is empty.
+ */
+template<typename T>
+auto aabbs_clamp_point(std::span<const Aabb<T>> aabbs, Vec<2, T> point) -> Vec<2, T>
+{
+    usz i = 0;
+    f64 closest_dist = INFINITY;
+    Vec<2, T> closest = point;
+
+#if defined(__SSE2__)
+    if constexpr (std::same_as<T, f32>) {
+        if (aabbs.size() >= 4) {
+            auto x = _mm_set1_ps(point.x);
+            auto y = _mm_set1_ps(point.y);
+            auto best_dist = _mm_set1_ps(INFINITY);
+            auto best_x = x;
+            auto best_y = y;
+            for (; i + 4 <= aabbs.size(); i += 4) {
+                detail::Aabb4f32 box(aabbs.data() + i);
+                auto cx = _mm_min_ps(_mm_max_ps(x, box.min_x), box.max_x);
+                auto cy = _mm_min_ps(_mm_max_ps(y, box.min_y), box.max_y);
+                auto dx = _mm_sub_ps(cx, x);
+                auto dy = _mm_sub_ps(cy, y);
+                auto dist = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+                auto closer = _mm_cmplt_ps(dist, best_dist);
+                best_dist = _mm_min_ps(dist, best_dist);
+                best_x = _mm_or_ps(_mm_and_ps(closer, cx), _mm_andnot_ps(closer, best_x));
+                best_y = _mm_or_ps(_mm_and_ps(closer, cy), _mm_andnot_ps(closer, best_y));
+            }
+
+            alignas(16) std::array<f32, 4> lane_dist, lane_x, lane_y;
+            _mm_store_ps(lane_dist.data(), best_dist);
+            _mm_store_ps(lane_x.data(), best_x);
+            _mm_store_ps(lane_y.data(), best_y);
+            for (u32 lane = 0; lane < 4; ++lane) {
+                if (lane_dist[lane] < closest_dist) {
+                    closest_dist = lane_dist[lane];
+                    closest = {lane_x[lane], lane_y[lane]};
+                }
+            }
+        }
+    }
+#endif
+
+    for (; i < aabbs.size(); ++i) {
+        auto pos = aabb_clamp_point(aabbs[i], point);
+        auto d = vec_cast<f64>(pos) - vec_cast<f64>(point);
+        f64 dist = d.x * d.x + d.y * d.y;
+        if (dist < closest_dist) {
+            closest = pos;
+            closest_dist = dist;
+        }
+    }
+
+    return closest;
+}
+
+// -----------------------------------------------------------------------------
+
 template<typename To, typename From>
 constexpr
 auto rect_cast(const Rect<From>& from) -> Rect<To>
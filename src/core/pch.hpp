@@ -41,6 +41,10 @@
 #include <cstring>
 #include <csignal>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 // -----------------------------------------------------------------------------
 
 #include <unistd.h>
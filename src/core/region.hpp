@@ -3,6 +3,18 @@
 #include "types.hpp"
 #include "math.hpp"
 
+// Regions with at most this many boxes are scanned rather than searched
+static constexpr usz region_scan_max = 16;
+
+/**
+ * A set of pixels, stored as y-x banded rectangles.
+ *
+ * `aabbs` is kept in canonical form: sorted by y then x, split into horizontal bands where every
+ * rectangle in a band shares the same top and bottom, with no overlapping or touching rectangles
+ * inside a band, and with vertically adjacent bands of identical spans merged together.
+ * This makes union, intersection and subtraction a linear sweep over both operands, and lets
+ * point queries binary search instead of testing every rectangle.
+ */
 template<typename T>
 struct Region
 {
@@ -13,8 +25,9 @@ struct Region
     Region() = default;
 
     Region(Aabb<T> aabb)
-        : aabbs{aabb}
-    {}
+    {
+        if (!is_empty(aabb)) aabbs.emplace_back(aabb);
+    }
 
 // -----------------------------------------------------------------------------
 
@@ -46,6 +59,7 @@ struct Region
 
 // -----------------------------------------------------------------------------
 
+    // Canonical form makes equal pixel sets compare equal
     constexpr auto operator==(const Region& other) const noexcept -> bool = default;
 
 // -----------------------------------------------------------------------------
@@ -60,82 +74,273 @@ struct Region
         return aabbs.empty();
     }
 
-    void add(Aabb<T> aabb)
+    auto bounds() const -> Aabb<T>
     {
-        aabbs.emplace_back(aabb);
+        if (aabbs.empty()) return {};
+
+        Aabb<T> bounds = {aabbs.front().min, aabbs.back().max, minmax};
+        for (auto& aabb : aabbs) {
+            bounds.min.x = std::min(bounds.min.x, aabb.min.x);
+            bounds.max.x = std::max(bounds.max.x, aabb.max.x);
+        }
+        return bounds;
     }
 
-    void subtract(Aabb<T> subtrahend)
+    void add(Aabb<T> aabb)
     {
-        usz prev_size = aabbs.size();
-        usz inplace = 0;
+        if (is_empty(aabb)) return;
+        if (aabbs.empty()) { aabbs.emplace_back(aabb); return; }
+        combine(Op::unite, std::span(&aabb, 1));
+    }
 
-        for (usz i = 0; i < prev_size; ++i) {
+    void add(const Region& other)
+    {
+        if (other.empty()) return;
+        if (aabbs.empty()) { aabbs = other.aabbs; return; }
+        combine(Op::unite, other.aabbs);
+    }
 
-            std::array<Aabb<T>, 4> split;
-            u32 count = aabb_subtract(aabbs[i], subtrahend, split.data());
+    void subtract(Aabb<T> subtrahend)
+    {
+        if (aabbs.empty() || is_empty(subtrahend)) return;
+        combine(Op::subtract, std::span(&subtrahend, 1));
+    }
 
-            // Update first aabb in-place
-            if (count > 0) {
-                aabbs[inplace++] = split[0];
-            }
+    void subtract(const Region& other)
+    {
+        if (aabbs.empty() || other.empty()) return;
+        combine(Op::subtract, other.aabbs);
+    }
 
-            // Append remaining aabbs to end
-            if (count > 1) {
-                aabbs.insert_range(aabbs.end(), std::span{split}.subspan(1, count - 1));
-            }
-        }
+    void intersect(Aabb<T> aabb)
+    {
+        if (is_empty(aabb)) { aabbs.clear(); return; }
+        combine(Op::intersect, std::span(&aabb, 1));
+    }
 
-        // Clean if hole left in list
-        if (inplace < prev_size) {
-            usz extra = aabbs.size() - prev_size;
-            usz to_delete = prev_size - inplace;
-            usz to_move = std::min(to_delete, extra);
-            std::copy(aabbs.end() - to_move, aabbs.end(), aabbs.begin() + inplace);
-            aabbs.erase(aabbs.begin() + inplace + extra);
-        }
+    void intersect(const Region& other)
+    {
+        if (other.empty()) { aabbs.clear(); return; }
+        combine(Op::intersect, other.aabbs);
     }
 
     template<typename T2>
     auto contains(Vec<2, T2> point) const -> bool
     {
-        for (auto aabb : aabbs) {
-            if (aabb_contains<T2>(aabb, point)) {
-                return true;
-            }
+        if constexpr (std::same_as<T, T2>) {
+            if (aabbs.size() <= region_scan_max) return aabbs_find_point<T>(aabbs, point) != aabbs.size();
         }
-        return false;
+
+        // Bands are disjoint and sorted, so bottoms are non-decreasing
+        auto band = std::ranges::upper_bound(aabbs, point.y, {}, [](auto& aabb) { return T2(aabb.max.y); });
+        if (band == aabbs.end() || T2(band->min.y) > point.y) return false;
+
+        auto band_last = band_end(band, aabbs.end());
+        auto span = std::ranges::upper_bound(band, band_last, point.x, {}, [](auto& aabb) { return T2(aabb.max.x); });
+        return span != band_last && T2(span->min.x) <= point.x;
     }
 
     template<typename T2>
     auto contains(Aabb<T2> needle) const -> bool
     {
-        for (auto aabb : aabbs) {
-            Aabb<T2> overlap;
-            aabb_intersects<T2>(aabb, needle, &overlap);
-            if (overlap == needle) return true;
+        if (needle.max.x <= needle.min.x || needle.max.y <= needle.min.y) return true;
+
+        // Every band overlapping the needle must be contiguous and have a single span covering it,
+        // as touching spans are always merged.
+        auto band = std::ranges::upper_bound(aabbs, needle.min.y, {}, [](auto& aabb) { return T2(aabb.max.y); });
+        T2 y = needle.min.y;
+        while (y < needle.max.y) {
+            if (band == aabbs.end() || T2(band->min.y) > y) return false;
+
+            auto band_last = band_end(band, aabbs.end());
+            auto span = std::ranges::upper_bound(band, band_last, needle.min.x, {}, [](auto& aabb) { return T2(aabb.max.x); });
+            if (span == band_last || T2(span->min.x) > needle.min.x || T2(span->max.x) < needle.max.x) return false;
+
+            y = T2(band->max.y);
+            band = band_last;
         }
-        return false;
+        return true;
     }
 
     template<typename T2>
     auto constrain(Vec<2, T2> point) const -> Vec<2, T2>
     {
-        f64 closest_dist = INFINITY;
-        Vec<2, T2> closest = {};
+        if (contains(point)) return point;
+
+        if (aabbs.empty()) return {};
 
-        for (auto aabb : aabbs) {
-            auto pos = aabb_clamp_point(aabb_cast<T2>(aabb), point);
-            if (pos == point) return point;
+        if constexpr (std::same_as<T, T2>) {
+            return aabbs_clamp_point<T>(aabbs, point);
+        } else {
+            f64 closest_dist = INFINITY;
+            Vec<2, T2> closest = {};
 
-            f64 dist = vec_distance(vec_cast<f64>(pos), vec_cast<f64>(point));
-            if (dist < closest_dist) {
-                closest = pos;
-                closest_dist = dist;
+            for (auto aabb : aabbs) {
+                auto pos = aabb_clamp_point(aabb_cast<T2>(aabb), point);
+
+                f64 dist = vec_distance(vec_cast<f64>(pos), vec_cast<f64>(point));
+                if (dist < closest_dist) {
+                    closest = pos;
+                    closest_dist = dist;
+                }
             }
+
+            return closest;
+        }
+    }
+
+// -----------------------------------------------------------------------------
+
+private:
+    enum class Op { unite, intersect, subtract };
+
+    static
+    auto is_empty(const Aabb<T>& aabb) -> bool
+    {
+        return !(aabb.max.x > aabb.min.x && aabb.max.y > aabb.min.y);
+    }
+
+    template<typename It>
+    static
+    auto band_end(It band, It end) -> It
+    {
+        auto y = band->min.y;
+        while (++band != end && band->min.y == y) {}
+        return band;
+    }
+
+    static
+    void push_span(std::vector<Aabb<T>>& out, T min_x, T max_x, T top, T bottom)
+    {
+        out.push_back({{min_x, top}, {max_x, bottom}, minmax});
+    }
+
+    /**
+     * Writes the spans of `op(a, b)` for a single band, where `a` and `b` are the (possibly empty)
+     * sorted spans of each operand that cover `[top, bottom)`.
+     */
+    static
+    void combine_band(Op op, std::span<const Aabb<T>> a, std::span<const Aabb<T>> b, T top, T bottom, std::vector<Aabb<T>>& out)
+    {
+        usz i = 0, j = 0;
+
+        switch (op) {
+            break;case Op::unite: {
+                bool pending = false;
+                T min_x = {}, max_x = {};
+                while (i < a.size() || j < b.size()) {
+                    auto& next = (j == b.size() || (i < a.size() && a[i].min.x < b[j].min.x)) ? a[i++] : b[j++];
+                    if (pending && next.min.x <= max_x) {
+                        max_x = std::max(max_x, next.max.x);
+                    } else {
+                        if (pending) push_span(out, min_x, max_x, top, bottom);
+                        min_x = next.min.x;
+                        max_x = next.max.x;
+                        pending = true;
+                    }
+                }
+                if (pending) push_span(out, min_x, max_x, top, bottom);
+            }
+            break;case Op::intersect:
+                while (i < a.size() && j < b.size()) {
+                    T min_x = std::max(a[i].min.x, b[j].min.x);
+                    T max_x = std::min(a[i].max.x, b[j].max.x);
+                    if (min_x < max_x) push_span(out, min_x, max_x, top, bottom);
+                    if (a[i].max.x < b[j].max.x) ++i; else ++j;
+                }
+            break;case Op::subtract:
+                for (; i < a.size(); ++i) {
+                    T x = a[i].min.x;
+                    while (j < b.size() && b[j].max.x <= x) ++j;
+                    for (usz k = j; k < b.size() && b[k].min.x < a[i].max.x; ++k) {
+                        if (b[k].min.x > x) push_span(out, x, b[k].min.x, top, bottom);
+                        x = std::max(x, b[k].max.x);
+                    }
+                    if (x < a[i].max.x) push_span(out, x, a[i].max.x, top, bottom);
+                }
+        }
+    }
+
+    /**
+     * Merges the band starting at `band` into the previous band if they touch and have identical spans.
+     * Returns the start of the last band in `out`.
+     */
+    static
+    auto coalesce(std::vector<Aabb<T>>& out, usz prev, usz band) -> usz
+    {
+        if (band == out.size()) return prev;
+        if (prev == band) return band;
+
+        usz count = out.size() - band;
+        if (band - prev != count || out[prev].max.y != out[band].min.y) return band;
+
+        for (usz i = 0; i < count; ++i) {
+            if (out[prev + i].min.x != out[band + i].min.x || out[prev + i].max.x != out[band + i].max.x) return band;
+        }
+
+        T bottom = out[band].max.y;
+        for (usz i = 0; i < count; ++i) out[prev + i].max.y = bottom;
+        out.resize(band);
+        return prev;
+    }
+
+    /**
+     * Replaces `aabbs` with `op(aabbs, other)`, sweeping down both operands one band at a time.
+     */
+    void combine(Op op, std::span<const Aabb<T>> other)
+    {
+        std::vector<Aabb<T>> out;
+        out.reserve(aabbs.size() + other.size());
+
+        auto a = aabbs.cbegin(), a_end = aabbs.cend();
+        auto b = other.begin(),  b_end = other.end();
+        auto a_band = a != a_end ? band_end(a, a_end) : a_end;
+        auto b_band = b != b_end ? band_end(b, b_end) : b_end;
+
+        // Start of the last band written, for coalescing
+        usz prev = 0;
+
+        T y = (a != a_end && b != b_end) ? std::min(a->min.y, b->min.y) : (a != a_end ? a->min.y : b->min.y);
+
+        while (a != a_end || b != b_end) {
+            bool has_a = a != a_end;
+            bool has_b = b != b_end;
+
+            // Intersections end with either operand, and subtractions with the minuend
+            if (op == Op::intersect && !(has_a && has_b)) break;
+            if (op == Op::subtract  && !has_a) break;
+
+            T a_top = has_a ? std::max(a->min.y, y) : T{};
+            T b_top = has_b ? std::max(b->min.y, y) : T{};
+
+            std::span<const Aabb<T>> a_spans, b_spans;
+            T top, bottom;
+
+            if (has_a && (!has_b || a_top < b_top)) {
+                top = a_top;
+                bottom = has_b ? std::min(a->max.y, b_top) : a->max.y;
+                a_spans = {a, a_band};
+            } else if (has_b && (!has_a || b_top < a_top)) {
+                top = b_top;
+                bottom = has_a ? std::min(b->max.y, a_top) : b->max.y;
+                b_spans = {b, b_band};
+            } else {
+                top = a_top;
+                bottom = std::min(a->max.y, b->max.y);
+                a_spans = {a, a_band};
+                b_spans = {b, b_band};
+            }
+
+            usz band = out.size();
+            combine_band(op, a_spans, b_spans, top, bottom, out);
+            prev = coalesce(out, prev, band);
+
+            y = bottom;
+            if (has_a && a->max.y <= y) { a = a_band; if (a != a_end) a_band = band_end(a, a_end); }
+            if (has_b && b->max.y <= y) { b = b_band; if (b != b_end) b_band = band_end(b, b_end); }
         }
 
-        return closest;
+        aabbs = std::move(out);
     }
 };
 
@@ -0,0 +1,160 @@
+#include "internal.hpp"
+
+// Transparent texels around each entry, on every side
+static constexpr u32 gpu_atlas_padding = 1;
+
+// Shelves more than this many times taller than an entry are only used once no new shelf fits
+static constexpr u32 gpu_atlas_shelf_waste_max = 2;
+
+struct GpuAtlasShelf
+{
+    u32 y;
+    u32 height;
+    u32 width; // Used from the left edge
+};
+
+struct GpuAtlas
+{
+    Gpu* gpu;
+    GpuAtlasCreateInfo info;
+
+    std::vector<GpuAtlasPage*> pages;
+
+    ~GpuAtlas();
+};
+
+struct GpuAtlasPage
+{
+    GpuAtlas* atlas;
+
+    Ref<GpuImage> image;
+
+    std::vector<GpuAtlasShelf> shelves;
+    u32 bottom; // Top of the unused area below the last shelf
+
+    ~GpuAtlasPage()
+    {
+        if (atlas) std::erase(atlas->pages, this);
+    }
+};
+
+GpuAtlas::~GpuAtlas()
+{
+    for (auto* page : pages) {
+        page->atlas = nullptr;
+    }
+}
+
+auto gpu_atlas_create(Gpu* gpu, const GpuAtlasCreateInfo& info) -> Ref<GpuAtlas>
+{
+    auto atlas = ref_create<GpuAtlas>();
+    atlas->gpu = gpu;
+    atlas->info = info;
+    return atlas;
+}
+
+static
+auto create_page(GpuAtlas* atlas) -> Ref<GpuAtlasPage>
+{
+    auto page = ref_create<GpuAtlasPage>();
+    page->atlas = atlas;
+    page->image = gpu_image_create(atlas->gpu, {
+        .extent = atlas->info.extent,
+        .format = atlas->info.format,
+        .usage = GpuImageUsage::texture | GpuImageUsage::transfer,
+    });
+    atlas->pages.emplace_back(page.get());
+    return page;
+}
+
+static
+auto allocate_in_page(GpuAtlasPage* page, vec2u32 cell) -> std::optional<vec2u32>
+{
+    auto extent = page->image->extent();
+
+    // Prefer the shortest shelf that fits, as long as it doesn't waste too much of its height
+    GpuAtlasShelf* best = nullptr;
+    GpuAtlasShelf* fallback = nullptr;
+    for (auto& shelf : page->shelves) {
+        if (shelf.height < cell.y || shelf.width + cell.x > extent.x) continue;
+        auto*& candidate = shelf.height <= cell.y * gpu_atlas_shelf_waste_max ? best : fallback;
+        if (!candidate || shelf.height < candidate->height) candidate = &shelf;
+    }
+
+    if (!best && page->bottom + cell.y <= extent.y) {
+        best = &page->shelves.emplace_back(page->bottom, cell.y, 0);
+        page->bottom += cell.y;
+    }
+
+    if (!best) best = fallback;
+    if (!best) return std::nullopt;
+
+    vec2u32 offset = {best->width, best->y};
+    best->width += cell.x;
+
+    return offset;
+}
+
+auto gpu_atlas_allocate(GpuAtlas* atlas, vec2u32 extent) -> Ref<GpuAtlasEntry>
+{
+    auto cell = extent + gpu_atlas_padding * 2;
+    if (cell.x > atlas->info.extent.x || cell.y > atlas->info.extent.y) return nullptr;
+
+    auto entry = ref_create<GpuAtlasEntry>();
+    entry->extent = extent;
+
+    std::optional<vec2u32> offset;
+    for (auto* page : atlas->pages) {
+        if ((offset = allocate_in_page(page, cell))) {
+            entry->page = page;
+            break;
+        }
+    }
+
+    if (!entry->page) {
+        entry->page = create_page(atlas);
+        offset = allocate_in_page(entry->page.get(), cell);
+    }
+
+    entry->image = entry->page->image.get();
+    entry->offset = *offset + gpu_atlas_padding;
+
+    return entry;
+}
+
+void gpu_atlas_entry_upload(GpuAtlasEntry* entry, std::span<const byte> data)
+{
+    auto* image = entry->image;
+    auto* gpu = image->context();
+
+    u32 texel_size = image->format()->texel_block_size;
+    auto extent = entry->extent;
+    auto cell = extent + gpu_atlas_padding * 2;
+
+    debug_assert(data.size() == usz(extent.x) * extent.y * texel_size);
+
+    // The whole cell is written, as page contents start out undefined
+    usz size = usz(cell.x) * cell.y * texel_size;
+    usz stride = usz(cell.x) * texel_size;
+    auto staging = gpu_staging_allocate(gpu, size, texel_size);
+    auto* texels = staging.buffer->host<byte>(staging.offset);
+    std::memset(texels, 0, size);
+    for (u32 y = 0; y < extent.y; ++y) {
+        std::memcpy(texels + (y + gpu_atlas_padding) * stride + gpu_atlas_padding * texel_size,
+                    data.data() + usz(y) * extent.x * texel_size,
+                    extent.x * texel_size);
+    }
+
+    gpu_copy_buffer_to_image(image, staging.buffer, {{{
+        .image_extent = cell,
+        .image_offset = vec_cast<i32>(entry->offset - gpu_atlas_padding),
+        .buffer_offset = u32(staging.offset),
+    }}});
+}
+
+auto gpu_atlas_entry_get_uv(GpuAtlasEntry* entry) -> aabb2f32
+{
+    auto page = vec_cast<f32>(entry->image->extent());
+    auto offset = vec_cast<f32>(entry->offset);
+    return {offset / page, (offset + vec_cast<f32>(entry->extent)) / page, minmax};
+}
@@ -9,6 +9,10 @@ auto gpu_buffer_create(Gpu* gpu, usz size, Flags<GpuBufferFlag> flags) -> Ref<Gp
 
     gpu->stats.active_buffers++;
 
+    // Host buffers stage uploads, which may be read from the transfer queue
+    std::array families { gpu->queue.family, gpu->transfer.family };
+    bool concurrent = gpu->transfer.queue && flags.contains(GpuBufferFlag::host);
+
     VmaAllocationInfo alloc_info;
     gpu_check(vmaCreateBuffer(gpu->vma,
         ptr_to(VkBufferCreateInfo {
@@ -18,7 +22,9 @@ auto gpu_buffer_create(Gpu* gpu, usz size, Flags<GpuBufferFlag> flags) -> Ref<Gp
                    | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
                    | VK_BUFFER_USAGE_TRANSFER_DST_BIT
                    | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = concurrent ? u32(families.size()) : 0u,
+            .pQueueFamilyIndices = families.data(),
         }),
         flags.contains(GpuBufferFlag::host)
             ? ptr_to(VmaAllocationCreateInfo {
@@ -3,24 +3,49 @@
 #include <core/enum.hpp>
 #include <core/stack.hpp>
 
-void gpu_queue_init(Gpu* gpu)
+static
+void queue_init(Gpu* gpu, GpuQueue* queue)
 {
-    gpu->vk.GetDeviceQueue(gpu->device, gpu->queue.family, 0, &gpu->queue.queue);
+    gpu->vk.GetDeviceQueue(gpu->device, queue->family, 0, &queue->queue);
 
     gpu_check(gpu->vk.CreateCommandPool(gpu->device, ptr_to(VkCommandPoolCreateInfo {
         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
-        .queueFamilyIndex = gpu->queue.family,
-    }), nullptr, &gpu->queue.pool));
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queue->family,
+    }), nullptr, &queue->pool));
 
-    gpu->queue.syncobj = gpu_syncobj_create(gpu);
+    queue->syncobj = gpu_syncobj_create(gpu);
+}
+
+void gpu_queue_init(Gpu* gpu)
+{
+    queue_init(gpu, &gpu->queue);
+
+    // Each queue waits on the other's timeline, which requires importable timeline syncobjs
+    if (gpu->transfer.family != VK_QUEUE_FAMILY_IGNORED && gpu->features.contains(GpuFeature::timelines)) {
+        log_info("Using dedicated transfer queue (family {}) for uploads", gpu->transfer.family);
+        queue_init(gpu, &gpu->transfer);
+    }
+}
+
+void gpu_queue_destroy(Gpu* gpu, GpuQueue* queue)
+{
+    queue->syncobj.destroy();
+
+    debug_assert(!queue->commands, "Unflushed commands");
+    queue->free.clear();
+    gpu->vk.DestroyCommandPool(gpu->device, queue->pool, nullptr);
 }
 
 // -----------------------------------------------------------------------------
 
 GpuCommands::~GpuCommands()
 {
-    gpu->vk.FreeCommandBuffers(gpu->device, gpu->queue.pool, 1, &buffer);
+    gpu->vk.FreeCommandBuffers(gpu->device, queue->pool, 1, &buffer);
+
+    if (timestamps.pool) {
+        gpu->vk.DestroyQueryPool(gpu->device, timestamps.pool, nullptr);
+    }
 
 #if GPU_VALIDATION_COMPATIBILITY
     if (validation.fence) {
@@ -29,27 +54,167 @@ GpuCommands::~GpuCommands()
 #endif
 }
 
-auto gpu_get_commands(Gpu* gpu) -> GpuCommands*
+static
+auto allocate(Gpu* gpu, GpuQueue* queue) -> Ref<GpuCommands>
 {
-    if (gpu->queue.commands) return gpu->queue.commands.get();
-
     auto commands = ref_create<GpuCommands>();
     commands->gpu = gpu;
+    commands->queue = queue;
 
     gpu_check(gpu->vk.AllocateCommandBuffers(gpu->device, ptr_to(VkCommandBufferAllocateInfo {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = gpu->queue.pool,
+        .commandPool = queue->pool,
         .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
         .commandBufferCount = 1,
     }), &commands->buffer));
 
+    if (queue == &gpu->queue && gpu->timings.period) {
+        gpu_check(gpu->vk.CreateQueryPool(gpu->device, ptr_to(VkQueryPoolCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = gpu_timestamp_passes_max * 2,
+        }), nullptr, &commands->timestamps.pool));
+    }
+
+    return commands;
+}
+
+static
+void recycle(GpuCommands* commands)
+{
+    auto* gpu = commands->gpu;
+    auto* queue = commands->queue;
+
+    commands->objects.clear();
+    commands->wait_value = 0;
+    commands->timestamps.passes.clear();
+    commands->timestamps.untimed = 0;
+
+    // Beyond the free limit, buffers are freed when their last reference is dropped
+    if (queue->free.size() >= gpu_commands_free_max) return;
+
+    gpu_check(gpu->vk.ResetCommandBuffer(commands->buffer, 0));
+
+#if GPU_VALIDATION_COMPATIBILITY
+    if (commands->validation.fence) {
+        gpu_check(gpu->vk.ResetFences(gpu->device, 1, &commands->validation.fence));
+    }
+#endif
+
+    queue->free.emplace_back(commands);
+}
+
+static
+auto get_commands(Gpu* gpu, GpuQueue* queue) -> GpuCommands*
+{
+    if (queue->commands) return queue->commands.get();
+
+    auto commands = queue->free.empty() ? allocate(gpu, queue) : queue->free.pop_back();
+
     gpu_check(gpu->vk.BeginCommandBuffer(commands->buffer, ptr_to(VkCommandBufferBeginInfo {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
     })));
 
-    gpu->queue.commands = std::move(commands);
+    if (commands->timestamps.pool) {
+        gpu->vk.CmdResetQueryPool(commands->buffer, commands->timestamps.pool, 0, gpu_timestamp_passes_max * 2);
+    }
+
+    queue->commands = std::move(commands);
+
+    return queue->commands.get();
+}
+
+auto gpu_get_commands(Gpu* gpu) -> GpuCommands*
+{
+    return get_commands(gpu, &gpu->queue);
+}
+
+auto gpu_get_upload_commands(GpuImage* image) -> GpuCommands*
+{
+    auto* base = static_cast<GpuImageBase*>(image->base());
+    auto* gpu = base->gpu;
+
+    // Images referenced by unsubmitted graphics commands are written in order with them
+    if (!gpu->transfer.queue || !base->data.concurrent || base->data.last_use > gpu->queue.submitted) {
+        gpu_protect(gpu, image);
+        return gpu_get_commands(gpu);
+    }
+
+    auto* commands = get_commands(gpu, &gpu->transfer);
+    commands->objects.emplace_back(image);
+
+    // Wait for previous graphics reads before overwriting the image
+    commands->wait_value = std::max(commands->wait_value, base->data.last_use);
 
-    return gpu->queue.commands.get();
+    return commands;
+}
+
+// -----------------------------------------------------------------------------
+
+auto gpu_timestamp_begin(GpuCommands* commands, GpuPassType type) -> u32
+{
+    auto& timestamps = commands->timestamps;
+    if (!timestamps.pool) return gpu_timestamp_none;
+
+    if (timestamps.passes.size() >= gpu_timestamp_passes_max) {
+        timestamps.untimed++;
+        return gpu_timestamp_none;
+    }
+
+    u32 pass = timestamps.passes.size();
+    timestamps.passes.emplace_back(type);
+    commands->gpu->vk.CmdWriteTimestamp2(commands->buffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, timestamps.pool, pass * 2);
+
+    return pass;
+}
+
+void gpu_timestamp_end(GpuCommands* commands, u32 pass)
+{
+    if (pass == gpu_timestamp_none) return;
+
+    commands->gpu->vk.CmdWriteTimestamp2(commands->buffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, commands->timestamps.pool, pass * 2 + 1);
+}
+
+static
+void resolve_timestamps(GpuCommands* commands)
+{
+    auto* gpu = commands->gpu;
+    auto& timestamps = commands->timestamps;
+
+    u32 count = timestamps.passes.size();
+    if (!count) return;
+
+    ThreadStack stack;
+    auto* values = stack.allocate<u64>(count * 2);
+
+    // The submission has completed, so every written query is available
+    gpu_check(gpu->vk.GetQueryPoolResults(gpu->device, timestamps.pool, 0, count * 2,
+        count * 2 * sizeof(u64), values, sizeof(u64), VK_QUERY_RESULT_64_BIT));
+
+    auto duration = [&](u64 begin, u64 end) {
+        return std::chrono::nanoseconds(i64(f64((end - begin) & gpu->timings.mask) * gpu->timings.period));
+    };
+
+    GpuTiming timing {
+        .submission = commands->submitted_value,
+        .total = duration(values[0], values[count * 2 - 1]),
+        .timed = count,
+        .untimed = timestamps.untimed,
+    };
+    for (auto[i, type] : timestamps.passes | std::views::enumerate) {
+        timing.passes[std::to_underlying(type)] += duration(values[i * 2], values[i * 2 + 1]);
+    }
+
+    gpu->timings.history[gpu->timings.count++ % gpu_timings_max] = timing;
+}
+
+auto gpu_get_timing(Gpu* gpu, u32 age) -> const GpuTiming*
+{
+    auto& timings = gpu->timings;
+    if (age >= timings.count || age >= gpu_timings_max) return nullptr;
+
+    return &timings.history[(timings.count - 1 - age) % gpu_timings_max];
 }
 
 // -----------------------------------------------------------------------------
@@ -60,6 +225,13 @@ void gpu_protect(Gpu* gpu, Ref<void> object)
     gpu_get_commands(gpu)->objects.emplace_back(std::move(object));
 }
 
+void gpu_protect(Gpu* gpu, GpuImage* image)
+{
+    if (!image) return;
+    static_cast<GpuImageBase*>(image->base())->data.last_use = gpu->queue.submitted + 1;
+    gpu_get_commands(gpu)->objects.emplace_back(image);
+}
+
 // -----------------------------------------------------------------------------
 
 static
@@ -88,16 +260,17 @@ auto submit_info(GpuBinarySemaphore* semaphore, VkPipelineStageFlags2 stages) ->
     };
 }
 
-auto gpu_flush(Gpu* gpu) -> GpuSyncpoint
+static
+auto submit(Gpu* gpu, GpuQueue* queue, std::span<const VkSemaphoreSubmitInfo> waits) -> GpuSyncpoint
 {
-    auto* commands = gpu->queue.commands.get();
+    auto* commands = queue->commands.get();
 
     gpu_check(gpu->vk.EndCommandBuffer(commands->buffer));
 
-    commands->submitted_value = ++gpu->queue.submitted;
+    commands->submitted_value = ++queue->submitted;
 
     GpuSyncpoint target {
-        .syncobj = gpu->queue.syncobj.get(),
+        .syncobj = queue->syncobj.get(),
         .value = commands->submitted_value,
     };
 
@@ -107,18 +280,21 @@ auto gpu_flush(Gpu* gpu) -> GpuSyncpoint
         : gpu_get_binary_semaphore(gpu);
 
 #if GPU_VALIDATION_COMPATIBILITY
-    if (signal && gpu->features.contains(GpuFeature::validation)) {
+    if (signal && gpu->features.contains(GpuFeature::validation) && !commands->validation.fence) {
         // When validation layers are enabled, they need visibility of command completion
         // otherwise they will complain about resources still being used.
+        // Fences are created once per command buffer, and reset when it is recycled.
         gpu_check(gpu->vk.CreateFence(gpu->device, ptr_to(VkFenceCreateInfo {
             .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
         }), nullptr, &commands->validation.fence));
     }
 #endif
 
-    gpu_check(gpu->vk.QueueSubmit2(gpu->queue.queue, 1,
+    gpu_check(gpu->vk.QueueSubmit2(queue->queue, 1,
         ptr_to(VkSubmitInfo2 {
             .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+            .waitSemaphoreInfoCount = u32(waits.size()),
+            .pWaitSemaphoreInfos = waits.data(),
             .commandBufferInfoCount = 1,
             .pCommandBufferInfos = ptr_to(VkCommandBufferSubmitInfo {
                 .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
@@ -140,16 +316,50 @@ auto gpu_flush(Gpu* gpu) -> GpuSyncpoint
         transfer(signal.get(), target.syncobj, target.value);
     }
 
-    gpu_wait({gpu->queue.syncobj.get(), gpu->queue.submitted}, [commands = Ref(commands)](u64) {
+    gpu_wait(target, [commands = Ref(commands)](u64) {
 #if GPU_VALIDATION_COMPATIBILITY
         if (commands->validation.fence) {
             auto* gpu = commands->gpu;
             gpu_check(gpu->vk.WaitForFences(gpu->device, 1, &commands->validation.fence, true, UINT64_MAX));
         }
 #endif
+        resolve_timestamps(commands.get());
+        recycle(commands.get());
     });
 
-    gpu->queue.commands = nullptr;
+    queue->commands = nullptr;
 
     return target;
 }
+
+void gpu_flush_uploads(Gpu* gpu)
+{
+    auto* commands = gpu->transfer.commands.get();
+    if (!commands) return;
+
+    if (commands->wait_value) {
+        submit(gpu, &gpu->transfer, {ptr_to(gpu_syncpoint_to_submit_info({
+            .syncobj = gpu->queue.syncobj.get(),
+            .value = commands->wait_value,
+            .stages = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        })), 1});
+    } else {
+        submit(gpu, &gpu->transfer, {});
+    }
+}
+
+auto gpu_flush(Gpu* gpu) -> GpuSyncpoint
+{
+    gpu_flush_uploads(gpu);
+
+    // Graphics work recorded after an upload must not start before it completes
+    if (gpu->transfer.submitted > gpu->transfer.awaited) {
+        gpu->transfer.awaited = gpu->transfer.submitted;
+        return submit(gpu, &gpu->queue, {ptr_to(gpu_syncpoint_to_submit_info({
+            .syncobj = gpu->transfer.syncobj.get(),
+            .value = gpu->transfer.submitted,
+        })), 1});
+    }
+
+    return submit(gpu, &gpu->queue, {});
+}
@@ -23,6 +23,7 @@
     DO(CreateCommandPool) \
     DO(AllocateCommandBuffers) \
     DO(FreeCommandBuffers) \
+    DO(ResetCommandBuffer) \
     DO(CreateSemaphore) \
     DO(CreatePipelineLayout) \
     DO(CreateDescriptorPool) \
@@ -47,6 +48,7 @@
     DO(DestroyFence) \
     DO(DestroyDescriptorPool) \
     DO(CmdClearColorImage) \
+    DO(CmdClearAttachments) \
     DO(ResetCommandPool) \
     DO(CreateBuffer) \
     DO(GetBufferMemoryRequirements) \
@@ -110,6 +112,11 @@
     DO(CmdSetColorBlendEquationEXT) \
     DO(CmdBindShadersEXT) \
     DO(GetSemaphoreCounterValue) \
+    DO(CreateQueryPool) \
+    DO(DestroyQueryPool) \
+    DO(CmdResetQueryPool) \
+    DO(CmdWriteTimestamp2) \
+    DO(GetQueryPoolResults) \
 
 #define GPU_DECLARE_FUNCTION(funcName, ...) PFN_vk##funcName funcName;
 
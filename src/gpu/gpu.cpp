@@ -11,11 +11,11 @@ Gpu::~Gpu()
 {
     log_info("GPU context destroyed");
 
-    queue.syncobj.destroy();
-    debug_assert(stats.active_syncobjs == 0, "{} unexpected syncobj", stats.active_syncobjs);
+    gpu_staging_destroy(this);
 
-    debug_assert(!queue.commands, "Unflushed commands");
-    vk.DestroyCommandPool(device, queue.pool, nullptr);
+    if (transfer.queue) gpu_queue_destroy(this, &transfer);
+    gpu_queue_destroy(this, &queue);
+    debug_assert(stats.active_syncobjs == 0, "{} unexpected syncobj", stats.active_syncobjs);
 
     debug_assert(stats.active_images == 0, "{} unexpected images", stats.active_images);
     debug_assert(stats.active_buffers == 0, "{} unexpected buffers", stats.active_buffers);
@@ -433,15 +433,33 @@ auto gpu_create(ExecContext* exec, Flags<GpuFeature> _features) -> Ref<Gpu>
         gpu_vulkan_enumerate(props, gpu->vk.GetPhysicalDeviceQueueFamilyProperties, gpu->physical_device);
 
         bool found = false;
+        gpu->transfer.family = VK_QUEUE_FAMILY_IGNORED;
         for (auto[i, queue_props] : props | std::views::enumerate) {
             VkQueueFlags require_flags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
             if ((queue_props.queueFlags & require_flags) == require_flags) {
                 gpu->queue.family = i;
                 found =true;
             }
+
+            // Transfer-only families map to copy engines that run independently of rendering.
+            // Coarse transfer granularities would restrict partial uploads, so those are skipped.
+            auto granularity = queue_props.minImageTransferGranularity;
+            if ((queue_props.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)) == VK_QUEUE_TRANSFER_BIT
+                    && granularity.width == 1 && granularity.height == 1 && granularity.depth == 1) {
+                gpu->transfer.family = i;
+            }
         }
 
         debug_assert(found);
+
+        // Timestamps wrap past the queue's valid bits, and are unsupported without any
+        if (u32 bits = props[gpu->queue.family].timestampValidBits) {
+            VkPhysicalDeviceProperties2 device_props { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+            gpu->vk.GetPhysicalDeviceProperties2(gpu->physical_device, &device_props);
+
+            gpu->timings.mask = bits >= 64 ? ~0ull : (1ull << bits) - 1;
+            gpu->timings.period = device_props.properties.limits.timestampPeriod;
+        }
     }
 
     // Device creation
@@ -453,6 +471,8 @@ auto gpu_create(ExecContext* exec, Flags<GpuFeature> _features) -> Ref<Gpu>
                 ptr_to(VkPhysicalDeviceFeatures2 {
                     .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
                     .features = {
+                        .shaderStorageImageReadWithoutFormat = true,
+                        .shaderStorageImageWriteWithoutFormat = true,
                         .shaderInt64 = true,
                         .shaderInt16 = true,
                     },
@@ -500,7 +520,7 @@ auto gpu_create(ExecContext* exec, Flags<GpuFeature> _features) -> Ref<Gpu>
                     .maintenance8 = true,
                 }),
             }}),
-            .queueCreateInfoCount = 1,
+            .queueCreateInfoCount = gpu->transfer.family != VK_QUEUE_FAMILY_IGNORED ? 2u : 1u,
             .pQueueCreateInfos = std::array {
                 VkDeviceQueueCreateInfo {
                     .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
@@ -515,6 +535,12 @@ auto gpu_create(ExecContext* exec, Flags<GpuFeature> _features) -> Ref<Gpu>
                     .queueCount = 1,
                     .pQueuePriorities = ptr_to(1.f),
                 },
+                VkDeviceQueueCreateInfo {
+                    .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                    .queueFamilyIndex = gpu->transfer.family,
+                    .queueCount = 1,
+                    .pQueuePriorities = ptr_to(1.f),
+                },
             }.data(),
             .enabledExtensionCount = u32(required_device_extensions.size()),
             .ppEnabledExtensionNames = required_device_extensions.data(),
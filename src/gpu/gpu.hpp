@@ -173,12 +173,58 @@ auto gpu_get_modifier_name(GpuDrmModifier) -> std::string;
 
 // -----------------------------------------------------------------------------
 
+struct GpuQueue
+{
+    u32 family;
+    VkQueue queue;
+    VkCommandPool pool;
+    Ref<struct GpuCommands> commands;
+    RefVector<struct GpuCommands> free;
+    Ref<GpuSyncobj> syncobj;
+    u64 submitted;
+
+    // Last submission on this queue that the graphics queue has waited for
+    u64 awaited;
+};
+
+// -----------------------------------------------------------------------------
+
 enum class GpuFeature : u32
 {
     validation = 1 << 0,
     timelines  = 1 << 1,
 };
 
+// -----------------------------------------------------------------------------
+
+enum class GpuPassType : u32
+{
+    render,
+    compute,
+    copy,
+};
+
+/**
+ * GPU execution time of a graphics queue submission, measured by timestamp queries written
+ * around each render pass, compute pass and copy. Resolved once the submission completes.
+ */
+struct GpuTiming
+{
+    u64 submission;
+
+    // From the start of the first timed pass to the end of the last
+    std::chrono::nanoseconds total;
+
+    // Summed pass durations, indexed by `GpuPassType`
+    std::array<std::chrono::nanoseconds, 3> passes;
+
+    u32 timed;
+    u32 untimed; // Passes beyond `gpu_timestamp_passes_max`
+};
+
+static constexpr u32 gpu_timings_max          = 256;
+static constexpr u32 gpu_timestamp_passes_max = 128;
+
 struct Gpu
 {
     GpuVulkanFunctions vk;
@@ -216,8 +262,21 @@ struct Gpu
         u32 active_samplers;
 
         u32 active_syncobjs;
+
+        // Cumulative bytes written to images by copies, and to ring buffers
+        u64 uploaded_bytes;
     } stats;
 
+    struct {
+        // Nanoseconds per timestamp tick, zero if the graphics queue can't write timestamps
+        f64 period;
+        u64 mask;
+
+        // Ring of the most recently resolved timings
+        std::array<GpuTiming, gpu_timings_max> history;
+        u64 count;
+    } timings;
+
     std::vector<VkSemaphore> free_binary_semaphores;
 
     VkDescriptorSetLayout set_layout;
@@ -230,14 +289,23 @@ struct Gpu
 
     ankerl::unordered_dense::segmented_map<GpuFormatPropertiesKey, GpuFormatProperties> format_props;
 
+    GpuQueue queue;
+
+    // Dedicated transfer queue for uploads, with a null `queue` if the device has none
+    GpuQueue transfer;
+
+    struct GpuStagingChunk
+    {
+        Ref<GpuBuffer> buffer;
+        usz used;
+        u64 point;
+    };
+
     struct {
-        u32 family;
-        VkQueue queue;
-        VkCommandPool pool;
-        Ref<struct GpuCommands> commands;
-        Ref<GpuSyncobj> syncobj;
-        u64 submitted;
-    } queue;
+        GpuStagingChunk current;
+        std::deque<GpuStagingChunk> in_flight;
+        RefVector<GpuBuffer> free;
+    } staging;
 
     ~Gpu();
 };
@@ -287,6 +355,9 @@ auto gpu_syncobj_export_syncfile(GpuSyncobj*, u64 source_point) -> Fd;
 auto gpu_syncobj_get_value(   GpuSyncobj*) -> u64;
 void gpu_syncobj_signal_value(GpuSyncobj*, u64 value);
 
+// Attaches the fence of a submitted source point to a point on the target syncobj, without waiting
+void gpu_syncobj_transfer(GpuSyncobj*, u64 target_point, GpuSyncpoint source);
+
 void gpu_syncobj_wait(GpuSyncobj*, GpuWaitFn*);
 
 // WARNING: Blocking
@@ -310,8 +381,17 @@ void gpu_wait(GpuSyncpoint sync, Fn&& fn)
 
 void gpu_protect(Gpu*, Ref<void>);
 
+// Protects an image, and records the current submission as the last use of its underlying image
+void gpu_protect(Gpu*, GpuImage*);
+
 auto gpu_flush(Gpu*) -> GpuSyncpoint;
 
+// Submits uploads recorded on the transfer queue, so they can run ahead of the next graphics submission
+void gpu_flush_uploads(Gpu*);
+
+// Timing of the `age`-th most recently completed submission, or null if it is no longer (or not yet) known
+auto gpu_get_timing(Gpu*, u32 age) -> const GpuTiming*;
+
 // -----------------------------------------------------------------------------
 
 struct GpuBuffer
@@ -392,6 +472,52 @@ struct GpuArray
 
 // -----------------------------------------------------------------------------
 
+/**
+ * Persistently mapped buffer for streaming transient per-frame data.
+ *
+ * Allocations are retired once the queue submission that was being recorded when they
+ * were made has completed. When in-flight allocations exhaust the buffer, it is replaced
+ * with a larger one and the old buffer is released once its last user completes.
+ */
+struct GpuRingBuffer
+{
+    Gpu* gpu;
+
+    Ref<GpuBuffer>       buffer;
+    Flags<GpuBufferFlag> flags;
+
+    // Monotonic byte positions, wrapped by buffer size on access
+    u64 head;
+    u64 tail;
+
+    struct Fence
+    {
+        u64 point;
+        u64 head;
+    };
+    std::deque<Fence> in_flight;
+};
+
+struct GpuRingAllocation
+{
+    GpuBuffer* buffer;
+    usz        offset;
+};
+
+auto gpu_ring_buffer_create(Gpu*, usz size, Flags<GpuBufferFlag>) -> Ref<GpuRingBuffer>;
+auto gpu_ring_buffer_allocate(GpuRingBuffer*, usz size, usz align) -> GpuRingAllocation;
+
+template<typename T>
+auto gpu_ring_buffer_upload(GpuRingBuffer* ring, std::span<const T> data) -> GpuArray<T>
+{
+    auto[buffer, offset] = gpu_ring_buffer_allocate(ring, data.size_bytes(), alignof(T));
+    GpuArray<T> array{buffer, data.size(), offset};
+    std::memcpy(array.host(), data.data(), data.size_bytes());
+    return array;
+}
+
+// -----------------------------------------------------------------------------
+
 enum class GpuImageUsage : u32
 {
     transfer_src = 1 << 0,
@@ -416,6 +542,7 @@ struct GpuImage
     auto handle()     -> VkImage;
     auto usage()      -> Flags<GpuImageUsage>;
     auto descriptor() -> GpuDescriptorId;
+    auto last_use()   -> GpuSyncpoint;
 };
 
 struct GpuImageCreateInfo
@@ -461,6 +588,7 @@ struct GpuSamplerCreateInfo
 {
     VkFilter mag;
     VkFilter min;
+    VkSamplerAddressMode address = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
 };
 
 auto gpu_sampler_create(Gpu*, const GpuSamplerCreateInfo&) -> Ref<GpuSampler>;
@@ -522,6 +650,27 @@ struct GpuRenderPassInfo
 
 void gpu_render(Gpu*, const GpuRenderPassInfo&, std::function_ref<void(GpuRenderPass*)>);
 
+void gpu_clear(GpuRenderPass*, vec4f32 color, std::span<const rect2i32> rects);
+
+// -----------------------------------------------------------------------------
+
+/**
+ * Records compute dispatches on the graphics queue.
+ *
+ * Dispatches see all previously recorded writes, and later work sees all writes made by dispatches.
+ * Storage images are accessed through the bindless heap, and must be protected by the caller.
+ */
+struct GpuComputePass;
+
+void gpu_push_constants(GpuComputePass*, u32 offset, std::span<const byte> data);
+void gpu_bind_shader(   GpuComputePass*, GpuShader*);
+void gpu_dispatch(      GpuComputePass*, vec2u32 groups);
+
+// Orders following dispatches after the writes of previous dispatches in the same pass
+void gpu_barrier(GpuComputePass*);
+
+void gpu_compute(Gpu*, std::function_ref<void(GpuComputePass*)>);
+
 // -----------------------------------------------------------------------------
 
 constexpr static u32 gpu_dma_max_planes = 4;
@@ -594,7 +743,47 @@ struct GpuImagePool
 {
     virtual ~GpuImagePool() = default;
 
-    virtual auto acquire(const GpuImageCreateInfo&) -> Ref<GpuImage> = 0;
+    // `age` receives the number of acquisitions since the returned image was last handed out by this pool
+    // for the same create info, or 0 if its contents are undefined. Matches the semantics of EGL_EXT_buffer_age.
+    virtual auto acquire(const GpuImageCreateInfo&, u32* age = nullptr) -> Ref<GpuImage> = 0;
 };
 
 auto gpu_image_pool_create(Gpu*) -> Ref<GpuImagePool>;
+
+// -----------------------------------------------------------------------------
+
+/**
+ * Packs small images into shared pages, so that they're sampled through a single image and descriptor.
+ *
+ * Entries are placed left to right on horizontal shelves, with new shelves opened below the last.
+ * Each entry is surrounded by a transparent texel of padding, so that linear filtering at its edges
+ * doesn't pick up its neighbours. Space is not reused within a page, which suits long-lived entries
+ * such as cursors. Pages are released once their last entry is destroyed.
+ */
+struct GpuAtlas;
+
+struct GpuAtlasCreateInfo
+{
+    vec2u32   extent; // Of each page
+    GpuFormat format;
+};
+
+struct GpuAtlasEntry
+{
+    Ref<struct GpuAtlasPage> page;
+
+    GpuImage* image;  // The page's image
+    vec2u32   offset; // In page texels
+    vec2u32   extent;
+};
+
+auto gpu_atlas_create(Gpu*, const GpuAtlasCreateInfo&) -> Ref<GpuAtlas>;
+
+// Returns null if `extent` (plus padding) doesn't fit in a page
+auto gpu_atlas_allocate(GpuAtlas*, vec2u32 extent) -> Ref<GpuAtlasEntry>;
+
+// Uploads tightly packed texels for the whole entry
+void gpu_atlas_entry_upload(GpuAtlasEntry*, std::span<const byte> data);
+
+// Normalized coordinates of the entry in its page, e.g. for `scene_texture_set_src`
+auto gpu_atlas_entry_get_uv(GpuAtlasEntry*) -> aabb2f32;
@@ -8,18 +8,27 @@ struct GpuDefaultImagePool : GpuImagePool
 
     std::vector<GpuImagePattern*> patterns;
 
-    virtual auto acquire(const GpuImageCreateInfo&) -> Ref<GpuImage> final override;
+    virtual auto acquire(const GpuImageCreateInfo&, u32* age) -> Ref<GpuImage> final override;
 
     ~GpuDefaultImagePool();
 };
 
+struct GpuPooledImage
+{
+    Ref<GpuImage> image;
+    u64           sequence;
+};
+
 struct GpuImagePattern
 {
     GpuDefaultImagePool* pool;
 
-    GpuFormatModifierSet    modifiers;
-    GpuImageCreateInfo      info;
-    RefVector<GpuImage> images;
+    GpuFormatModifierSet        modifiers;
+    GpuImageCreateInfo          info;
+    std::vector<GpuPooledImage> images;
+
+    // Incremented on every acquire, used to compute buffer ages
+    u64 sequence;
 
     ~GpuImagePattern()
     {
@@ -69,19 +78,29 @@ auto find_pattern(GpuDefaultImagePool* pool, const GpuImageCreateInfo& info) ->
 static
 auto make_lease(GpuImagePattern* pattern, Ref<GpuImage> image)
 {
-    return gpu_lease_image(std::move(image), [pattern = Ref(pattern)](Ref<GpuImage> image) {
-        pattern->images.emplace_back(std::move(image));
+    return gpu_lease_image(std::move(image), [pattern = Ref(pattern), sequence = pattern->sequence](Ref<GpuImage> image) {
+        pattern->images.emplace_back(std::move(image), sequence);
     });
 }
 
-auto GpuDefaultImagePool::acquire(const GpuImageCreateInfo& info) -> Ref<GpuImage>
+auto GpuDefaultImagePool::acquire(const GpuImageCreateInfo& info, u32* age) -> Ref<GpuImage>
 {
     auto pattern = find_pattern(this, info);
 
+    auto sequence = ++pattern->sequence;
+
     if (!pattern->images.empty()) {
-        return make_lease(pattern.get(), pattern->images.pop_back());
+        // Prefer the most recently used image, as it requires the least repair
+        auto iter = std::ranges::max_element(pattern->images, {}, &GpuPooledImage::sequence);
+        auto pooled = std::move(*iter);
+        pattern->images.erase(iter);
+
+        if (age) *age = u32(std::min<u64>(sequence - pooled.sequence, UINT32_MAX));
+        return make_lease(pattern.get(), std::move(pooled.image));
     }
 
+    if (age) *age = 0;
+
     auto image = gpu_image_create(gpu, info);
 
     return make_lease(pattern.get(), std::move(image));
@@ -64,6 +64,12 @@ auto GpuImage::handle()     -> VkImage              { return get_base(this)->dat
 auto GpuImage::usage()      -> Flags<GpuImageUsage> { return get_base(this)->data.usage;    }
 auto GpuImage::descriptor() -> GpuDescriptorId      { return get_base(this)->data.id;       }
 
+auto GpuImage::last_use() -> GpuSyncpoint
+{
+    auto* base = get_base(this);
+    return {base->gpu->queue.syncobj.get(), base->data.last_use};
+}
+
 // -----------------------------------------------------------------------------
 
 struct gpu_image_vma : GpuImageBase
@@ -102,6 +108,10 @@ auto gpu_image_create(Gpu* gpu, const GpuImageCreateInfo& info) -> Ref<GpuImage>
     image->data.format = info.format;
     image->data.usage = info.usage;
 
+    // Upload targets are shared with the transfer queue, instead of transferring ownership around every upload
+    std::array families { gpu->queue.family, gpu->transfer.family };
+    image->data.concurrent = gpu->transfer.queue && info.usage.contains(GpuImageUsage::transfer_dst);
+
     VmaAllocationInfo alloc_info;
     gpu_check(vmaCreateImage(gpu->vma, ptr_to(VkImageCreateInfo {
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
@@ -113,7 +123,9 @@ auto gpu_image_create(Gpu* gpu, const GpuImageCreateInfo& info) -> Ref<GpuImage>
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .tiling = VK_IMAGE_TILING_OPTIMAL,
         .usage = gpu_image_usage_to_vulkan(info.usage),
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .sharingMode = image->data.concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = image->data.concurrent ? u32(families.size()) : 0u,
+        .pQueueFamilyIndices = families.data(),
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
     }), ptr_to(VmaAllocationCreateInfo {
         .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
@@ -183,12 +195,17 @@ void gpu_cmd_copy_image_to_buffer(GpuBuffer* buffer, GpuImage* image)
     gpu_protect(gpu, image);
     gpu_protect(gpu, buffer);
 
-    gpu->vk.CmdCopyImageToBuffer(get_cmdbuf(gpu), image->handle(), VK_IMAGE_LAYOUT_GENERAL, buffer->buffer, 1, ptr_to(VkBufferImageCopy {
+    auto* commands = gpu_get_commands(gpu);
+    auto timestamp = gpu_timestamp_begin(commands, GpuPassType::copy);
+
+    gpu->vk.CmdCopyImageToBuffer(commands->buffer, image->handle(), VK_IMAGE_LAYOUT_GENERAL, buffer->buffer, 1, ptr_to(VkBufferImageCopy {
         .bufferOffset = 0,
         .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
         .imageOffset = {},
         .imageExtent = { extent.x, extent.y, 1 },
     }));
+
+    gpu_timestamp_end(commands, timestamp);
 }
 
 void gpu_copy_buffer_to_image(GpuImage* image, GpuBuffer* buffer, std::span<const GpuBufferImageCopy> regions)
@@ -197,11 +214,12 @@ void gpu_copy_buffer_to_image(GpuImage* image, GpuBuffer* buffer, std::span<cons
 
     ThreadStack stack;
 
-    gpu_protect(gpu, image);
-    gpu_protect(gpu, buffer);
+    auto* commands = gpu_get_upload_commands(image);
+    commands->objects.emplace_back(buffer);
 
     auto* copies = stack.allocate<VkBufferImageCopy>(regions.size());
     for (auto[i, region] : regions | std::views::enumerate) {
+        gpu->stats.uploaded_bytes += u64(region.image_extent.x) * region.image_extent.y * image->format()->texel_block_size;
         copies[i] = {
             .bufferOffset = region.buffer_offset,
             .bufferRowLength = region.buffer_row_length,
@@ -211,19 +229,28 @@ void gpu_copy_buffer_to_image(GpuImage* image, GpuBuffer* buffer, std::span<cons
         };
     }
 
-    gpu->vk.CmdCopyBufferToImage(get_cmdbuf(gpu), buffer->buffer, image->handle(), VK_IMAGE_LAYOUT_GENERAL, regions.size(), copies);
+    auto timestamp = gpu_timestamp_begin(commands, GpuPassType::copy);
+    gpu->vk.CmdCopyBufferToImage(commands->buffer, buffer->buffer, image->handle(), VK_IMAGE_LAYOUT_GENERAL, regions.size(), copies);
+    gpu_timestamp_end(commands, timestamp);
 }
 
 void gpu_copy_memory_to_image(GpuImage* image, std::span<const byte> data, std::span<const GpuBufferImageCopy> regions)
 {
     auto* gpu = image->context();
 
-    // TODO: This should be stored persistently for transfers
-    Ref buffer = gpu_buffer_create(gpu, data.size(), GpuBufferFlag::host);
+    auto staging = gpu_staging_allocate(gpu, data.size(), image->format()->texel_block_size);
 
-    std::memcpy(buffer->host_address, data.data(), data.size());
+    std::memcpy(staging.buffer->host<void>(staging.offset), data.data(), data.size());
+
+    ThreadStack stack;
+
+    auto* offset_regions = stack.allocate<GpuBufferImageCopy>(regions.size());
+    for (auto[i, region] : regions | std::views::enumerate) {
+        offset_regions[i] = region;
+        offset_regions[i].buffer_offset += staging.offset;
+    }
 
-    gpu_copy_buffer_to_image(image, buffer.get(), regions);
+    gpu_copy_buffer_to_image(image, staging.buffer, {offset_regions, regions.size()});
 }
 
 auto gpu_image_compute_linear_offset(GpuFormat format, vec2u32 pos, u32 row_stride_bytes) -> u32
@@ -249,9 +276,9 @@ auto gpu_sampler_create(Gpu* gpu, const GpuSamplerCreateInfo& info) -> Ref<GpuSa
         .magFilter = info.mag,
         .minFilter = info.min,
         .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
-        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
-        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
-        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+        .addressModeU = info.address,
+        .addressModeV = info.address,
+        .addressModeW = info.address,
         .anisotropyEnable = false,
         .maxLod = VK_LOD_CLAMP_NONE,
         .borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
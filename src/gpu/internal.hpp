@@ -70,6 +70,12 @@ struct GpuImageBase : GpuImage
         GpuDescriptorId id;
 
         Flags<GpuImageUsage> usage;
+
+        // Last queue submission that referenced this image
+        u64 last_use;
+
+        // Shared between the graphics and transfer queues, and so can be written by uploads on either
+        bool concurrent;
     } data;
 
     virtual ~GpuImageBase();
@@ -91,15 +97,31 @@ void gpu_allocate_sampler_descriptor(GpuSampler*);
 
 // -----------------------------------------------------------------------------
 
+static constexpr u32 gpu_commands_free_max = 4;
+
 struct GpuCommands
 {
     Gpu* gpu;
+    GpuQueue* queue;
 
     VkCommandBuffer buffer;
+
+    // Objects kept alive until the submission completes.
+    // Cleared on completion, keeping its storage for the next recording on this buffer.
     RefVector<void> objects;
 
     u64 submitted_value;
 
+    // Graphics queue point to wait for before execution, for transfer queue commands
+    u64 wait_value;
+
+    // Begin and end timestamps of each timed pass, for graphics queue commands
+    struct {
+        VkQueryPool pool;
+        std::vector<GpuPassType> passes;
+        u32 untimed;
+    } timestamps;
+
 #if GPU_VALIDATION_COMPATIBILITY
     struct {
         VkFence fence;
@@ -109,8 +131,18 @@ struct GpuCommands
     ~GpuCommands();
 };
 
-void gpu_queue_init(  Gpu*);
-auto gpu_get_commands(Gpu*) -> GpuCommands*;
+void gpu_queue_init(   Gpu*);
+void gpu_queue_destroy(Gpu*, GpuQueue*);
+auto gpu_get_commands( Gpu*) -> GpuCommands*;
+
+// Returns the commands that writes to `image` should be recorded in, protecting it until they complete.
+// These are on the transfer queue where possible, and otherwise the graphics queue.
+auto gpu_get_upload_commands(GpuImage*) -> GpuCommands*;
+
+// Brackets a pass in timestamp queries. Returns the pass to end, or `gpu_timestamp_none` if it isn't timed.
+static constexpr u32 gpu_timestamp_none = ~0u;
+auto gpu_timestamp_begin(GpuCommands*, GpuPassType) -> u32;
+void gpu_timestamp_end(  GpuCommands*, u32 pass);
 
 // -----------------------------------------------------------------------------
 
@@ -126,3 +158,18 @@ struct GpuBinarySemaphore
 };
 
 auto gpu_get_binary_semaphore(Gpu*) -> Ref<GpuBinarySemaphore>;
+
+// -----------------------------------------------------------------------------
+
+static constexpr usz gpu_staging_chunk_size = 4 * 1024 * 1024;
+static constexpr u32 gpu_staging_free_max   = 4;
+
+struct GpuStagingAllocation
+{
+    GpuBuffer* buffer;
+    usz        offset;
+};
+
+// Allocates host visible upload space, valid until the currently recording submission completes
+auto gpu_staging_allocate(Gpu*, usz size, usz align) -> GpuStagingAllocation;
+void gpu_staging_destroy( Gpu*);
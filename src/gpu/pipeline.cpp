@@ -217,6 +217,37 @@ void gpu_draw_indexed(GpuRenderPass* pass, const GpuDrawInfo& info)
     gpu->vk.CmdDrawIndexed(cmd, info.index_count, info.instance_count, info.first_index, info.vertex_offset, info.first_instance);
 }
 
+void gpu_clear(GpuRenderPass* pass, vec4f32 color, std::span<const rect2i32> rects)
+{
+    auto[gpu, cmd] = *pass;
+
+    if (rects.empty()) return;
+
+    ThreadStack stack;
+
+    auto* vk_rects = stack.allocate<VkClearRect>(rects.size());
+    for (u32 i = 0; i < rects.size(); ++i) {
+        vk_rects[i] = VkClearRect {
+            .rect {
+                .offset{     rects[i].origin.x,      rects[i].origin.y  },
+                .extent{ u32(rects[i].extent.x), u32(rects[i].extent.y) },
+            },
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        };
+    }
+
+    gpu->vk.CmdClearAttachments(cmd, 1, ptr_to(VkClearAttachment {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .colorAttachment = 0,
+        .clearValue = {
+            .color = {
+                .float32 = { color.x, color.y, color.z, color.w }
+            }
+        },
+    }), u32(rects.size()), vk_rects);
+}
+
 static
 void reset_graphics_state(GpuRenderPass* pass)
 {
@@ -249,7 +280,11 @@ void reset_graphics_state(GpuRenderPass* pass)
 
 void gpu_render(Gpu* gpu, const GpuRenderPassInfo& info, std::function_ref<void(GpuRenderPass*)> fn)
 {
-    auto cmd = gpu_get_commands(gpu)->buffer;
+    auto* commands = gpu_get_commands(gpu);
+    auto cmd = commands->buffer;
+
+    auto timestamp = gpu_timestamp_begin(commands, GpuPassType::render);
+    defer { gpu_timestamp_end(commands, timestamp); };
 
     gpu_protect(gpu, info.target);
 
@@ -293,3 +328,86 @@ void gpu_render(Gpu* gpu, const GpuRenderPassInfo& info, std::function_ref<void(
 
     gpu->vk.CmdEndRendering(cmd);
 }
+
+// -----------------------------------------------------------------------------
+
+struct GpuComputePass
+{
+    Gpu* gpu;
+    VkCommandBuffer cmd;
+};
+
+static
+void memory_barrier(GpuComputePass* pass,
+                    VkPipelineStageFlags2 src_stages, VkAccessFlags2 src_access,
+                    VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access)
+{
+    auto[gpu, cmd] = *pass;
+
+    gpu->vk.CmdPipelineBarrier2(cmd, ptr_to(VkDependencyInfo {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = ptr_to(VkMemoryBarrier2 {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask = src_stages,
+            .srcAccessMask = src_access,
+            .dstStageMask = dst_stages,
+            .dstAccessMask = dst_access,
+        }),
+    }));
+}
+
+void gpu_push_constants(GpuComputePass* pass, u32 offset, std::span<const byte> data)
+{
+    auto[gpu, cmd] = *pass;
+
+    debug_assert(offset + data.size() <= gpu_push_constant_size, "{} > {}", offset + data.size(), gpu_push_constant_size);
+    gpu->vk.CmdPushConstants(cmd, gpu->pipeline_layout, VK_SHADER_STAGE_ALL, offset, data.size(), data.data());
+}
+
+void gpu_bind_shader(GpuComputePass* pass, GpuShader* shader)
+{
+    auto[gpu, cmd] = *pass;
+
+    debug_assert(shader->stage == VK_SHADER_STAGE_COMPUTE_BIT);
+    gpu->vk.CmdBindShadersEXT(cmd, 1, &shader->stage, &shader->shader);
+}
+
+void gpu_dispatch(GpuComputePass* pass, vec2u32 groups)
+{
+    auto[gpu, cmd] = *pass;
+
+    if (!groups.x || !groups.y) return;
+    gpu->vk.CmdDispatch(cmd, groups.x, groups.y, 1);
+}
+
+void gpu_barrier(GpuComputePass* pass)
+{
+    memory_barrier(pass,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+}
+
+void gpu_compute(Gpu* gpu, std::function_ref<void(GpuComputePass*)> fn)
+{
+    auto* commands = gpu_get_commands(gpu);
+    auto cmd = commands->buffer;
+
+    auto timestamp = gpu_timestamp_begin(commands, GpuPassType::compute);
+    defer { gpu_timestamp_end(commands, timestamp); };
+
+    GpuComputePass pass{gpu, cmd};
+
+    // Make previous rendering and copies visible to the dispatches
+    memory_barrier(&pass,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,   VK_ACCESS_2_MEMORY_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+
+    gpu->vk.CmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, gpu->pipeline_layout, 0, 1, &gpu->set, 0, nullptr);
+
+    fn(&pass);
+
+    memory_barrier(&pass,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,   VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT);
+}
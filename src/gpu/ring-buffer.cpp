@@ -0,0 +1,80 @@
+#include "internal.hpp"
+
+auto gpu_ring_buffer_create(Gpu* gpu, usz size, Flags<GpuBufferFlag> flags) -> Ref<GpuRingBuffer>
+{
+    auto ring = ref_create<GpuRingBuffer>();
+    ring->gpu = gpu;
+    ring->flags = flags;
+    ring->buffer = gpu_buffer_create(gpu, std::bit_ceil(size), flags);
+    return ring;
+}
+
+static
+void retire(GpuRingBuffer* ring)
+{
+    if (ring->in_flight.empty()) return;
+
+    auto completed = gpu_syncobj_get_value(ring->gpu->queue.syncobj.get());
+
+    while (!ring->in_flight.empty() && ring->in_flight.front().point <= completed) {
+        ring->tail = ring->in_flight.front().head;
+        ring->in_flight.pop_front();
+    }
+}
+
+static
+void grow(GpuRingBuffer* ring, usz min_size)
+{
+    auto size = std::bit_ceil(std::max(ring->buffer->size * 2, min_size));
+
+    log_debug("Growing ring buffer from {} to {}", FmtBytes(ring->buffer->size), FmtBytes(size));
+
+    // In-flight allocations keep the old buffer alive through their submission's protected objects
+    ring->buffer = gpu_buffer_create(ring->gpu, size, ring->flags);
+    ring->in_flight.clear();
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+auto gpu_ring_buffer_allocate(GpuRingBuffer* ring, usz size, usz align) -> GpuRingAllocation
+{
+    auto* gpu = ring->gpu;
+
+    retire(ring);
+
+    auto try_allocate = [&](u64* offset) {
+        auto capacity = ring->buffer->size;
+        auto start = align_up_power2(ring->head, align);
+
+        // Allocations may not straddle the end of the buffer
+        if ((start % capacity) + size > capacity) {
+            start = align_up_power2(start, capacity);
+        }
+
+        if (start + size - ring->tail > capacity) return false;
+
+        *offset = start;
+        return true;
+    };
+
+    u64 start;
+    if (!try_allocate(&start)) {
+        grow(ring, size + align);
+        try_allocate(&start);
+    }
+
+    ring->head = start + size;
+    gpu->stats.uploaded_bytes += size;
+
+    // Tie allocation to the submission currently being recorded
+
+    auto point = gpu->queue.submitted + 1;
+    if (ring->in_flight.empty() || ring->in_flight.back().point != point) {
+        ring->in_flight.emplace_back(point, ring->head);
+        gpu_protect(gpu, ring->buffer.get());
+    } else {
+        ring->in_flight.back().head = ring->head;
+    }
+
+    return { ring->buffer.get(), usz(start % ring->buffer->size) };
+}
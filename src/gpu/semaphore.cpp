@@ -83,6 +83,13 @@ void gpu_syncobj_import_syncfile(GpuSyncobj* syncobj, u64 target_point, fd_t syn
     unix_check<drmSyncobjTransfer>(gpu->drm.fd, syncobj->syncobj, target_point, gpu->drm.syncobj, 0, 0);
 }
 
+void gpu_syncobj_transfer(GpuSyncobj* syncobj, u64 target_point, GpuSyncpoint source)
+{
+    auto* gpu = syncobj->gpu;
+
+    unix_check<drmSyncobjTransfer>(gpu->drm.fd, syncobj->syncobj, target_point, source.syncobj->syncobj, source.value, 0);
+}
+
 auto gpu_syncobj_export_syncfile(GpuSyncobj* syncobj, u64 source_point) -> Fd
 {
     auto* gpu = syncobj->gpu;
@@ -70,6 +70,11 @@ vec4f32 image_load(GpuImageHandle h, vec2i32 idx)
     return imageLoad(gpu_heap_storage[nonuniformEXT(u32(h.img))], idx);
 }
 
+void image_store(GpuImageHandle h, vec2i32 idx, vec4f32 value)
+{
+    imageStore(gpu_heap_storage[nonuniformEXT(u32(h.img))], idx, value);
+}
+
 // -----------------------------------------------------------------------------
 
 vec4f32 unpack_unorm4u8(vec4u8 v) { return vec4f32(v) / 255.0; }
@@ -0,0 +1,73 @@
+#include "internal.hpp"
+
+static
+void retire(Gpu* gpu)
+{
+    auto& staging = gpu->staging;
+
+    if (staging.in_flight.empty()) return;
+
+    auto completed = gpu_syncobj_get_value(gpu->queue.syncobj.get());
+
+    while (!staging.in_flight.empty() && staging.in_flight.front().point <= completed) {
+        auto buffer = std::move(staging.in_flight.front().buffer);
+        staging.in_flight.pop_front();
+
+        // Oversized chunks are only kept for the upload that required them
+        if (buffer->size == gpu_staging_chunk_size && staging.free.size() < gpu_staging_free_max) {
+            staging.free.emplace_back(std::move(buffer));
+        }
+    }
+}
+
+static
+void next_chunk(Gpu* gpu, usz min_size)
+{
+    auto& staging = gpu->staging;
+
+    if (staging.current.buffer) {
+        staging.in_flight.emplace_back(std::move(staging.current));
+    }
+
+    if (min_size <= gpu_staging_chunk_size && !staging.free.empty()) {
+        staging.current = { staging.free.pop_back() };
+        return;
+    }
+
+    auto size = std::max(min_size, gpu_staging_chunk_size);
+    if (size > gpu_staging_chunk_size) {
+        log_debug("Allocating oversized staging chunk: {}", FmtBytes(size));
+    }
+
+    staging.current = { gpu_buffer_create(gpu, size, GpuBufferFlag::host) };
+}
+
+auto gpu_staging_allocate(Gpu* gpu, usz size, usz align) -> GpuStagingAllocation
+{
+    auto& staging = gpu->staging;
+
+    retire(gpu);
+
+    auto aligned = [&] {
+        return (staging.current.used + align - 1) / align * align;
+    };
+
+    if (!staging.current.buffer || aligned() + size > staging.current.buffer->size) {
+        next_chunk(gpu, size);
+    }
+
+    auto offset = aligned();
+    staging.current.used = offset + size;
+
+    // Chunks are retired after the last submission that used them
+    staging.current.point = gpu->queue.submitted + 1;
+
+    return { staging.current.buffer.get(), offset };
+}
+
+void gpu_staging_destroy(Gpu* gpu)
+{
+    gpu->staging.current = {};
+    gpu->staging.in_flight.clear();
+    gpu->staging.free.clear();
+}
@@ -7,6 +7,36 @@
 
 // -----------------------------------------------------------------------------
 
+static
+auto is_plane_claimed(IoContext* io, u32 plane_id) -> bool
+{
+    return std::ranges::any_of(io->drm->outputs, [&](IoDrmOutput* output) {
+        return output->cursor.plane_id == plane_id
+            || std::ranges::contains(output->overlays, plane_id, &IoDrmOverlay::plane_id);
+    });
+}
+
+static
+auto find_planes(IoContext* io, IoDrmResources* resources, drmModeCrtc* crtc, u64 type) -> std::vector<drmModePlane*>
+{
+    auto crtc_index = std::ranges::find(resources->crtcs, crtc) - resources->crtcs.begin();
+
+    std::vector<drmModePlane*> planes;
+    for (auto* plane : resources->planes) {
+        if (!(plane->possible_crtcs & (1 << crtc_index))) continue;
+
+        // Planes may be usable by multiple CRTCs, only claim each once
+        if (is_plane_claimed(io, plane->plane_id)) continue;
+
+        IoDrmPropertyMap props{io->drm->fd, plane->plane_id, DRM_MODE_OBJECT_PLANE};
+        if (props.get_prop_value("type") == type) {
+            planes.emplace_back(plane);
+        }
+    }
+
+    return planes;
+}
+
 static
 void add_output(IoContext* io, IoDrmResources* resources, drmModeConnector* connector)
 {
@@ -77,6 +107,69 @@ void add_output(IoContext* io, IoDrmResources* resources, drmModeConnector* conn
     output->size = {crtc->width, crtc->height};
     output->format_set = parse_plane_formats(io, resources, plane);
 
+    // Check variable refresh support
+
+    {
+        IoDrmPropertyMap connector_prop{io->drm->fd, connector->connector_id, DRM_MODE_OBJECT_CONNECTOR};
+        output->vrr.capable = connector_prop.properties.contains("vrr_capable")
+            && connector_prop.get_prop_value("vrr_capable")
+            && output->crtc_prop.properties.contains("VRR_ENABLED");
+
+        if (output->vrr.capable) {
+            output->vrr.enabled = output->crtc_prop.get_prop_value("VRR_ENABLED");
+
+            // Commits only update the schedule when the state changes, which it may not if already enabled
+            output->schedule.vrr = output->vrr.enabled;
+
+            if (auto range = parse_refresh_range(io, &connector_prop)) {
+                log_warn("  vrr: {} - {} Hz", range->min_hz, range->max_hz);
+                output->vrr.max_frame_time = std::chrono::nanoseconds(std::chrono::seconds(1)) / range->min_hz;
+            } else {
+                log_warn("  vrr: unknown range");
+            }
+        }
+    }
+
+    // Find cursor plane
+
+    if (auto cursor_planes = find_planes(io, resources, crtc, DRM_PLANE_TYPE_CURSOR); !cursor_planes.empty()) {
+        auto* cursor_plane = cursor_planes.front();
+        u64 width = 64, height = 64;
+        drmGetCap(io->drm->fd, DRM_CAP_CURSOR_WIDTH,  &width);
+        drmGetCap(io->drm->fd, DRM_CAP_CURSOR_HEIGHT, &height);
+
+        log_warn("  cursor plane: {} ({}, {})", cursor_plane->plane_id, width, height);
+
+        output->cursor.plane_id = cursor_plane->plane_id;
+        output->cursor.plane_prop = IoDrmPropertyMap(io->drm->fd, cursor_plane->plane_id, DRM_MODE_OBJECT_PLANE);
+        output->cursor.size = {u32(width), u32(height)};
+        output->cursor.format_set = parse_plane_formats(io, resources, cursor_plane);
+    }
+
+    // Find overlay planes
+
+    for (auto* overlay_plane : find_planes(io, resources, crtc, DRM_PLANE_TYPE_OVERLAY)) {
+        if (output->overlays.size() >= io_drm_overlays_max) break;
+
+        auto& overlay = output->overlays.emplace_back();
+        overlay.plane_id = overlay_plane->plane_id;
+        overlay.plane_prop = IoDrmPropertyMap(io->drm->fd, overlay_plane->plane_id, DRM_MODE_OBJECT_PLANE);
+
+        // Layers are always presented above the primary plane
+        if (overlay.plane_prop.properties.contains("zpos") && output->plane_prop.properties.contains("zpos")
+                && overlay.plane_prop.get_prop_value("zpos") <= output->plane_prop.get_prop_value("zpos")) {
+            output->overlays.pop_back();
+            continue;
+        }
+
+        overlay.format_set = parse_plane_formats(io, resources, overlay_plane);
+        for (auto&[format, modifiers] : overlay.format_set) {
+            for (auto modifier : modifiers) output->overlay_format_set.add(format, modifier);
+        }
+
+        log_warn("  overlay plane: {}", overlay_plane->plane_id);
+    }
+
     io->drm->outputs.emplace_back(output.get());
     io_output_add(output.get());
     io_output_post_configure(output.get());
@@ -88,6 +181,15 @@ void add_output(IoContext* io, IoDrmResources* resources, drmModeConnector* conn
 static
 void on_page_flip(fd_t fd, u32 sequence, u32 tv_sec, u32 tv_usec, u32 crtc_id, void* data);
 
+static
+void add_cursor_properties(IoDrmOutput*, drmModeAtomicReq*);
+
+static
+void commit_cursor(IoDrmOutput*);
+
+static
+void repeat_frame_later(IoDrmOutput*, std::chrono::steady_clock::time_point);
+
 // -----------------------------------------------------------------------------
 
 void io_drm_init(IoContext* io)
@@ -165,10 +267,28 @@ void on_page_flip(fd_t fd, u32 sequence, u32 tv_sec, u32 tv_usec, u32 crtc_id, v
 {
     auto* output = static_cast<IoDrmOutput*>(data);
 
+    // Timestamps are guaranteed to be monotonic by DRM_CAP_TIMESTAMP_MONOTONIC
+    auto time = steady_clock_from_timespec<CLOCK_MONOTONIC>({
+        .tv_sec = tv_sec,
+        .tv_nsec = i64(tv_usec) * 1000,
+    });
+    io_output_post_vblank(output, time, sequence);
+
     output->current_image = output->pending_image;
+    output->cursor.current_image = output->cursor.pending_image;
+    for (auto& overlay : output->overlays) {
+        overlay.current_image = overlay.pending_image;
+    }
 
     output->commit_available = true;
     io_output_try_redraw(output);
+
+    // Flush cursor updates that arrived while the flip was pending, if no frame was committed in their place
+    commit_cursor(output);
+
+    if (output->vrr.enabled) {
+        repeat_frame_later(output, time);
+    }
 }
 
 // -----------------------------------------------------------------------------
@@ -182,7 +302,7 @@ auto get_image_fb2(IoContext* io, GpuImage* image) -> u32
     std::optional<u32> found = std::nullopt;
     std::erase_if(io->drm->buffer_cache, [&](const auto& entry) {
         if (!entry.image) {
-            drmCloseBufferHandle(io->drm->fd, entry.fb2_handle);
+            if (entry.fb2_handle) drmCloseBufferHandle(io->drm->fd, entry.fb2_handle);
             return true;
         }
         if (entry.image.get() == image) found = entry.fb2_handle;
@@ -202,8 +322,12 @@ auto get_image_fb2(IoContext* io, GpuImage* image) -> u32
     u32 pitches[4] = {};
     u32 offsets[4] = {};
     u64 modifiers[4] = {};
+    bool imported = true;
     for (u32 i = 0; i < dma_params.planes.count; ++i) {
-        unix_check<drmPrimeFDToHandle>(io->drm->fd, dma_params.planes[i].fd.get(), &handles[i]);
+        if (unix_check<drmPrimeFDToHandle>(io->drm->fd, dma_params.planes[i].fd.get(), &handles[i]).err()) {
+            imported = false;
+            break;
+        }
         log_warn("  plane[{}] prime fd {} -> GEM handle {}", i, dma_params.planes[i].fd.get(), handles[i]);
         pitches[i] = dma_params.planes[i].stride;
         offsets[i] = dma_params.planes[i].offset;
@@ -213,31 +337,160 @@ auto get_image_fb2(IoContext* io, GpuImage* image) -> u32
     // Import
 
     u32 fb2_handle = 0;
-    unix_check<drmModeAddFB2WithModifiers>(io->drm->fd,
-        size.x, size.y,
-        format->drm, handles, pitches, offsets, modifiers,
-        &fb2_handle, DRM_MODE_FB_MODIFIERS);
+    if (imported && unix_check<drmModeAddFB2WithModifiers>(io->drm->fd,
+            size.x, size.y,
+            format->drm, handles, pitches, offsets, modifiers,
+            &fb2_handle, DRM_MODE_FB_MODIFIERS).err())
+    {
+        fb2_handle = 0;
+    }
 
     // Close GEM handles
 
     std::flat_set<u32> unique_handles;
     unique_handles.insert_range(handles);
+    unique_handles.erase(0);
     for (auto handle : unique_handles) drmCloseBufferHandle(io->drm->fd, handle);
 
+    // Failed imports are cached too, so that client images are only rejected once
+    if (!fb2_handle) {
+        log_warn("  failed to import FB2 buffer");
+    }
+
     return io->drm->buffer_cache.emplace_back(image, fb2_handle).fb2_handle;
 }
 
 // -----------------------------------------------------------------------------
 
-void IoDrmOutput::commit(
+static
+auto assign_overlays(IoDrmOutput* output, std::span<const IoOutputLayer> layers, std::vector<const IoOutputLayer*>* assigned) -> bool
+{
+    assigned->assign(output->overlays.size(), nullptr);
+
+    for (auto& layer : layers) {
+        auto* image = layer.image;
+        auto overlay = std::ranges::find_if(output->overlays, [&](auto& o) {
+            return !(*assigned)[&o - output->overlays.data()]
+                && o.format_set.get(image->format()).contains(image->modifier());
+        });
+        if (overlay == output->overlays.end()) return false;
+
+        (*assigned)[overlay - output->overlays.begin()] = &layer;
+    }
+
+    return true;
+}
+
+static
+auto add_overlay_properties(IoDrmOutput* output, drmModeAtomicReq* req, std::span<const IoOutputLayer* const> assigned) -> bool
+{
+    for (auto[overlay, layer] : std::views::zip(output->overlays, assigned)) {
+        auto plane_set = [&](std::string_view name, u64 value) {
+            drmModeAtomicAddProperty(req, overlay.plane_id, overlay.plane_prop.get_prop_id(name), value);
+        };
+
+        if (!layer) {
+            if (overlay.active) {
+                plane_set("FB_ID", 0);
+                plane_set("CRTC_ID", 0);
+            }
+            continue;
+        }
+
+        auto fb2_handle = get_image_fb2(output->io, layer->image);
+        if (!fb2_handle) return false;
+
+        auto extent = layer->image->extent();
+
+        plane_set("FB_ID", fb2_handle);
+        plane_set("CRTC_ID", output->crtc_id);
+        plane_set("SRC_X", 0);
+        plane_set("SRC_Y", 0);
+        plane_set("SRC_W", extent.x << 16);
+        plane_set("SRC_H", extent.y << 16);
+        plane_set("CRTC_X", u64(i64(layer->dst.origin.x)));
+        plane_set("CRTC_Y", u64(i64(layer->dst.origin.y)));
+        plane_set("CRTC_W", layer->dst.extent.x);
+        plane_set("CRTC_H", layer->dst.extent.y);
+    }
+
+    return true;
+}
+
+auto IoDrmOutput::test_layers(std::span<const IoOutputLayer> layers) -> bool
+{
+    if (layers.empty()) return true;
+
+    // Layers are tested against the last committed image, which shares its configuration with the next
+    if (!pending_image) return false;
+
+    std::vector<u64> config = {pending_image->format().index, pending_image->modifier()};
+    for (auto& layer : layers) {
+        // Imports are checked every time, as they can fail for individual images
+        if (!get_image_fb2(io, layer.image)) return false;
+
+        auto extent = layer.image->extent();
+        config.insert(config.end(), {
+            layer.image->format().index, layer.image->modifier(), extent.x, extent.y,
+            u64(layer.dst.origin.x), u64(layer.dst.origin.y), u64(layer.dst.extent.x), u64(layer.dst.extent.y),
+        });
+    }
+
+    if (auto iter = std::ranges::find(layer_tests, config, &IoDrmLayerTest::config); iter != layer_tests.end()) {
+        return iter->result;
+    }
+
+    bool result = [&] {
+        std::vector<const IoOutputLayer*> assigned;
+        if (!assign_overlays(this, layers, &assigned)) return false;
+
+        auto req = drmModeAtomicAlloc();
+        defer { drmModeAtomicFree(req); };
+
+        auto plane_set = [&](std::string_view name, u64 value) {
+            drmModeAtomicAddProperty(req, primary_plane_id, plane_prop.get_prop_id(name), value);
+        };
+
+        plane_set("FB_ID", get_image_fb2(io, pending_image.get()));
+        plane_set("SRC_X", 0);
+        plane_set("SRC_Y", 0);
+        plane_set("SRC_W", pending_image->extent().x << 16);
+        plane_set("SRC_H", pending_image->extent().y << 16);
+        plane_set("CRTC_X", 0);
+        plane_set("CRTC_Y", 0);
+        plane_set("CRTC_W", size.x);
+        plane_set("CRTC_H", size.y);
+
+        if (!add_overlay_properties(this, req, assigned)) return false;
+
+        return unix_check<drmModeAtomicCommit, EINVAL, ERANGE, ENOSPC>(io->drm->fd, req,
+            DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_NONBLOCK, nullptr).ok();
+    }();
+
+    // Configurations change rarely, so a small cache covers the common cases
+    if (layer_tests.size() >= io_drm_layer_tests_max) layer_tests.clear();
+    layer_tests.emplace_back(std::move(config), result);
+
+    log_debug("Tested {} overlay layer(s): {}", layers.size(), result ? "accepted" : "rejected");
+
+    return result;
+}
+
+auto IoDrmOutput::commit(
     GpuImage* image,
     GpuSyncpoint acquire,
-    Flags<IoOutputCommitFlag> in_flags)
+    Flags<IoOutputCommitFlag> in_flags,
+    std::span<const IoOutputLayer> layers) -> bool
 {
     debug_assert(commit_available);
-    commit_available = false;
+
+    bool scanout = in_flags.contains(IoOutputCommitFlag::scanout);
 
     auto fb2_handle = get_image_fb2(io, image);
+    if (!fb2_handle) {
+        debug_assert(scanout, "Failed to import composited image");
+        return false;
+    }
 
     auto req = drmModeAtomicAlloc();
     defer { drmModeAtomicFree(req); };
@@ -259,14 +512,240 @@ void IoDrmOutput::commit(
     plane_set("CRTC_W", size.x);
     plane_set("CRTC_H", size.y);
 
-    auto flags = DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+    // Toggling VRR can cause the panel to flicker, so it's only written when the policy changes
+    bool vrr_enabled = vrr.capable && in_flags.contains(IoOutputCommitFlag::vrr);
+    if (vrr_enabled != vrr.enabled) {
+        drmModeAtomicAddProperty(req, crtc_id, crtc_prop.get_prop_id("VRR_ENABLED"), vrr_enabled);
+    }
+
+    // Carry any pending cursor update along with the frame
+    if (cursor.dirty) add_cursor_properties(this, req);
+
+    // Layers are expected to have passed `test_layers`, any that can't be placed are dropped
+    std::vector<const IoOutputLayer*> assigned;
+    if (!assign_overlays(this, layers, &assigned) || !add_overlay_properties(this, req, assigned)) {
+        log_error("Failed to assign {} overlay layer(s)", layers.size());
+        assigned.assign(overlays.size(), nullptr);
+        add_overlay_properties(this, req, assigned);
+    }
+
+    // Client images may be in a format or layout that the plane can't scan out,
+    // so check with the kernel before committing to them.
+    if (scanout && unix_check<drmModeAtomicCommit, EINVAL, ERANGE>(io->drm->fd, req,
+            DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_NONBLOCK, nullptr).err())
+    {
+        return false;
+    }
 
-    drmModeAtomicAddProperty(req, crtc_id, crtc_prop.get_prop_id("VRR_ENABLED"), true);
+    auto flags = DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
 
     if (unix_check<drmModeAtomicCommit>(io->drm->fd, req, flags, this).err()) {
         debug_assert_fail("IoDrmOutput::commit", "TODO: FAILED TO COMMIT");
     }
 
+    commit_available = false;
+
     pending_image = image;
     last_commit_time = std::chrono::steady_clock::now();
+
+    io_output_post_commit(this, acquire);
+
+    if (vrr_enabled != vrr.enabled) {
+        log_debug("VRR {}", vrr_enabled ? "enabled" : "disabled");
+        vrr.enabled = vrr_enabled;
+        schedule.vrr = vrr_enabled;
+    }
+    if (vrr.repeat) exec_timer_cancel(vrr.repeat.get());
+
+    if (cursor.dirty) {
+        cursor.dirty = false;
+        cursor.in_fence = nullptr;
+        cursor.pending_image = cursor.image;
+    }
+
+    for (auto[overlay, layer] : std::views::zip(overlays, assigned)) {
+        overlay.active = layer;
+        overlay.pending_image = layer ? layer->image : nullptr;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static
+void add_cursor_properties(IoDrmOutput* output, drmModeAtomicReq* req)
+{
+    auto& cursor = output->cursor;
+
+    auto plane_set = [&](std::string_view name, u64 value) {
+        drmModeAtomicAddProperty(req, cursor.plane_id, cursor.plane_prop.get_prop_id(name), value);
+    };
+
+    if (!cursor.image) {
+        plane_set("FB_ID", 0);
+        plane_set("CRTC_ID", 0);
+        return;
+    }
+
+    auto size = cursor.image->extent();
+
+    plane_set("FB_ID", get_image_fb2(output->io, cursor.image.get()));
+    plane_set("CRTC_ID", output->crtc_id);
+    plane_set("SRC_X", 0);
+    plane_set("SRC_Y", 0);
+    plane_set("SRC_W", size.x << 16);
+    plane_set("SRC_H", size.y << 16);
+    plane_set("CRTC_X", u64(i64(cursor.position.x)));
+    plane_set("CRTC_Y", u64(i64(cursor.position.y)));
+    plane_set("CRTC_W", size.x);
+    plane_set("CRTC_H", size.y);
+
+    // The fence only needs to be waited on once, after which moves are applied immediately
+    if (cursor.in_fence) {
+        plane_set("IN_FENCE_FD", cursor.in_fence.get());
+    }
+}
+
+static
+void commit_cursor(IoDrmOutput* output)
+{
+    auto& cursor = output->cursor;
+
+    cursor.commit_later.unlink();
+
+    if (!cursor.dirty) return;
+
+    // Pending updates are picked up by the next commit, either one queued
+    // for an upcoming frame or from the page flip handler.
+    if (!output->commit_available || output->frame_requested) return;
+
+    auto req = drmModeAtomicAlloc();
+    defer { drmModeAtomicFree(req); };
+
+    add_cursor_properties(output, req);
+
+    auto flags = DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+
+    if (unix_check<drmModeAtomicCommit>(output->io->drm->fd, req, flags, output).err()) {
+        return;
+    }
+
+    output->commit_available = false;
+
+    cursor.dirty = false;
+    cursor.in_fence = nullptr;
+    cursor.pending_image = cursor.image;
+}
+
+static
+void commit_cursor_later(IoDrmOutput* output)
+{
+    // Deferred until idle, so that bursts of pointer motion are coalesced and
+    // so that updates made while building a frame are committed along with it.
+    output->cursor.dirty = true;
+    output->cursor.commit_later = output->io->exec->idle.listen([output] {
+        commit_cursor(output);
+    });
+}
+
+auto IoDrmOutput::set_cursor(GpuImage* image, GpuSyncpoint done) -> bool
+{
+    if (!image) {
+        if (cursor.image) {
+            cursor.image = nullptr;
+            cursor.in_fence = nullptr;
+            commit_cursor_later(this);
+        }
+        return true;
+    }
+
+    if (!cursor.plane_id) return false;
+    if (image->extent() != cursor.size) return false;
+    if (!get_image_fb2(io, image)) return false;
+
+    auto in_fence = gpu_syncobj_export_syncfile(done.syncobj, done.value);
+
+    // Check that the plane accepts the image before replacing the current cursor
+
+    auto req = drmModeAtomicAlloc();
+    defer { drmModeAtomicFree(req); };
+
+    auto previous = std::exchange(cursor.image, image);
+    add_cursor_properties(this, req);
+    cursor.image = std::move(previous);
+
+    if (unix_check<drmModeAtomicCommit, EINVAL, ERANGE>(io->drm->fd, req,
+            DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_NONBLOCK, nullptr).err())
+    {
+        return false;
+    }
+
+    cursor.image = image;
+    cursor.in_fence = std::move(in_fence);
+    commit_cursor_later(this);
+
+    return true;
+}
+
+void IoDrmOutput::move_cursor(vec2i32 position)
+{
+    if (cursor.position == position) return;
+
+    cursor.position = position;
+
+    if (cursor.image) {
+        commit_cursor_later(this);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static constexpr std::chrono::microseconds io_drm_vrr_repeat_margin{1500};
+
+static
+void repeat_frame(IoDrmOutput* output)
+{
+    // A new frame is on its way, which will refresh the panel in time on its own
+    if (!output->commit_available || output->frame_requested) return;
+    if (!output->current_image) return;
+
+    auto req = drmModeAtomicAlloc();
+    defer { drmModeAtomicFree(req); };
+
+    drmModeAtomicAddProperty(req, output->primary_plane_id, output->plane_prop.get_prop_id("FB_ID"),
+        get_image_fb2(output->io, output->current_image.get()));
+
+    if (output->cursor.dirty) add_cursor_properties(output, req);
+
+    auto flags = DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+
+    if (unix_check<drmModeAtomicCommit>(output->io->drm->fd, req, flags, output).err()) {
+        return;
+    }
+
+    output->commit_available = false;
+    output->pending_image = output->current_image;
+
+    if (output->cursor.dirty) {
+        output->cursor.dirty = false;
+        output->cursor.in_fence = nullptr;
+        output->cursor.pending_image = output->cursor.image;
+    }
+}
+
+static
+void repeat_frame_later(IoDrmOutput* output, std::chrono::steady_clock::time_point last_flip)
+{
+    // Low framerate compensation: when content updates slower than the panel's minimum
+    // refresh rate, the last frame is presented again before the panel would be forced
+    // to refresh on its own, keeping frame pacing under our control.
+    if (!output->vrr.max_frame_time.count()) return;
+
+    if (!output->vrr.repeat) {
+        output->vrr.repeat = exec_timer_create(output->io->exec, [output] {
+            repeat_frame(output);
+        });
+    }
+    exec_timer_set(output->vrr.repeat.get(), last_flip + output->vrr.max_frame_time - io_drm_vrr_repeat_margin);
 }
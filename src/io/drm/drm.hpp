@@ -49,6 +49,31 @@ struct IoDrmPropertyMap
 
 // -----------------------------------------------------------------------------
 
+static constexpr u32 io_drm_overlays_max = 3;
+
+struct IoDrmOverlay
+{
+    u32 plane_id;
+    IoDrmPropertyMap plane_prop;
+
+    GpuFormatSet format_set;
+
+    // True if the plane is enabled in the last committed state
+    bool active;
+
+    Ref<GpuImage> current_image;
+    Ref<GpuImage> pending_image;
+};
+
+static constexpr u32 io_drm_layer_tests_max = 64;
+
+struct IoDrmLayerTest
+{
+    // Format, modifier, extent and destination of the primary image and each layer
+    std::vector<u64> config;
+    bool result;
+};
+
 struct IoDrmOutput : IoOutputBase
 {
     u32 primary_plane_id;
@@ -63,19 +88,65 @@ struct IoDrmOutput : IoOutputBase
 
     GpuFormatSet format_set;
 
-    std::chrono::steady_clock::time_point last_commit_time = {};
+    struct {
+        u32 plane_id;
+        IoDrmPropertyMap plane_prop;
+
+        vec2u32 size;
+        GpuFormatSet format_set;
+
+        Ref<GpuImage> image;
+        vec2i32 position;
+        Fd in_fence;
+
+        // True if `image` or `position` have changed since the last atomic commit
+        bool dirty;
+        Listener<void()> commit_later;
+
+        Ref<GpuImage> current_image;
+        Ref<GpuImage> pending_image;
+    } cursor;
+
+    std::vector<IoDrmOverlay> overlays;
+    GpuFormatSet overlay_format_set;
+
+    // Results of TEST_ONLY commits, by layer configuration
+    std::vector<IoDrmLayerTest> layer_tests;
+
+    struct {
+        bool capable;
+        bool enabled;
 
-    GpuFormatSet formats;
+        // Longest time the panel can hold a frame, zero if unknown.
+        // Frames are repeated before this to keep the refresh rate within range.
+        std::chrono::nanoseconds max_frame_time;
+        Ref<ExecTimer> repeat;
+    } vrr;
+
+    std::chrono::steady_clock::time_point last_commit_time = {};
 
     virtual auto info() -> IoOutputInfo final override
     {
         return {
             .size = size,
-            .formats = &formats,
+            .formats = &format_set,
+            .vrr_capable = vrr.capable,
+            .cursor = {
+                .size = cursor.size,
+                .formats = &cursor.format_set,
+            },
+            .overlays = {
+                .count = u32(overlays.size()),
+                .formats = &overlay_format_set,
+            },
         };
     }
 
-    virtual void commit(GpuImage*, GpuSyncpoint done, Flags<IoOutputCommitFlag>) final override;
+    virtual auto commit(GpuImage*, GpuSyncpoint done, Flags<IoOutputCommitFlag>, std::span<const IoOutputLayer>) -> bool final override;
+    virtual auto test_layers(std::span<const IoOutputLayer>) -> bool final override;
+
+    virtual auto set_cursor(GpuImage*, GpuSyncpoint done) -> bool final override;
+    virtual void move_cursor(vec2i32 position) final override;
 };
 
 struct IoDrmBuffer
@@ -96,3 +167,11 @@ struct IoDrm
 // -----------------------------------------------------------------------------
 
 auto parse_plane_formats(IoContext* io, IoDrmResources* resources, drmModePlane* plane) -> GpuFormatSet;
+
+struct IoDrmRefreshRange
+{
+    u32 min_hz;
+    u32 max_hz;
+};
+
+auto parse_refresh_range(IoContext* io, IoDrmPropertyMap* connector_prop) -> std::optional<IoDrmRefreshRange>;
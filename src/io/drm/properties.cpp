@@ -145,3 +145,37 @@ auto parse_plane_formats(IoContext* io, IoDrmResources* resources, drmModePlane*
 
     return set;
 }
+
+// -----------------------------------------------------------------------------
+
+auto parse_refresh_range(IoContext* io, IoDrmPropertyMap* connector_prop) -> std::optional<IoDrmRefreshRange>
+{
+    if (!connector_prop->properties.contains("EDID")) return std::nullopt;
+
+    auto blob_id = connector_prop->get_prop_value("EDID");
+    if (!blob_id) return std::nullopt;
+
+    auto blob = drmModeGetPropertyBlob(io->drm->fd, blob_id);
+    if (!blob) return std::nullopt;
+    defer { drmModeFreePropertyBlob(blob); };
+
+    auto edid = std::span(static_cast<const u8*>(blob->data), blob->length);
+    if (edid.size() < 128) return std::nullopt;
+
+    // Search the base block's four 18-byte descriptors for display range limits (tag 0xFD)
+    for (u32 i = 0; i < 4; ++i) {
+        auto descriptor = edid.subspan(54 + i * 18, 18);
+        if (descriptor[0] || descriptor[1] || descriptor[2] || descriptor[3] != 0xFD) continue;
+
+        // Byte 4 flags a +255 offset for the min (bit 0) and max (bit 1) vertical rates
+        IoDrmRefreshRange range {
+            .min_hz = descriptor[5] + ((descriptor[4] & 0b01) ? 255u : 0u),
+            .max_hz = descriptor[6] + ((descriptor[4] & 0b10) ? 255u : 0u),
+        };
+        if (!range.min_hz || range.max_hz < range.min_hz) return std::nullopt;
+
+        return range;
+    }
+
+    return std::nullopt;
+}
@@ -74,8 +74,31 @@ struct IoOutputBase : IoOutput
     bool commit_available = true;
 
     virtual void request_frame() final override;
+    virtual auto flip_interval() -> std::chrono::nanoseconds final override;
     Listener<void()> try_redraw;
 
+    /**
+     * Frames are delayed to start as late as possible before the next vblank, so that they
+     * sample the most recent state. Scheduling is disabled until the backend reports vblanks,
+     * and while variable refresh is active, as vblanks then follow commits.
+     */
+    struct {
+        std::chrono::steady_clock::time_point last_vblank;
+        u32                                   last_sequence;
+        std::chrono::nanoseconds              refresh;
+        std::chrono::nanoseconds              last_interval; // Between the two most recent vblanks
+
+        // Decaying maximum of the time taken from `output_frame` to GPU completion
+        std::chrono::nanoseconds render_estimate;
+
+        std::chrono::steady_clock::time_point frame_start;
+
+        Ref<ExecTimer> timer;
+        bool           ready;
+
+        bool vrr;
+    } schedule;
+
     virtual ~IoOutputBase();
 };
 
@@ -83,6 +106,12 @@ void io_output_try_redraw(IoOutputBase*);
 void io_output_try_redraw_later(IoOutputBase*);
 void io_output_post_configure(IoOutputBase*);
 
+// Records a vblank from the backend, with `sequence` counting vblanks since an arbitrary point
+void io_output_post_vblank(IoOutputBase*, std::chrono::steady_clock::time_point, u32 sequence);
+
+// Measures the cost of the current frame, completed by `done`
+void io_output_post_commit(IoOutputBase*, GpuSyncpoint done);
+
 void io_output_add(   IoOutputBase*);
 void io_output_remove(IoOutputBase*);
 
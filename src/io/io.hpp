@@ -37,21 +37,52 @@ struct IoInputDevice
 
 enum class IoOutputCommitFlag : u32
 {
-    vsync = 1 << 0,
+    vsync   = 1 << 0,
+
+    // The image is owned by a client and is presented without composition.
+    // The output is tested first, and the commit is rejected if the image can't be scanned out.
+    scanout = 1 << 1,
+
+    // Enables variable refresh rate, if supported by the output. Frames are then
+    // presented as soon as they are committed, instead of at a fixed rate.
+    vrr     = 1 << 2,
 };
 
 struct IoOutputInfo
 {
     vec2u32 size;
     const GpuFormatSet* formats;
+
+    bool vrr_capable;
+
+    // Cursor plane, with a zero size if the output has none
+    struct {
+        vec2u32 size;
+        const GpuFormatSet* formats;
+    } cursor;
+
+    // Overlay planes, and the formats supported by any of them
+    struct {
+        u32 count;
+        const GpuFormatSet* formats;
+    } overlays;
+};
+
+/**
+ * A client-owned image presented on an overlay plane, above the committed image.
+ */
+struct IoOutputLayer
+{
+    GpuImage* image;
+    rect2i32  dst; // In output pixels
 };
 
 /**
  * Generic output device interface.
  *
- * TODO: Support multi-plane configuration query and present.
- *       This interface is mostly temporary - the acquire/present
- *       model won't work for direct scanout of client-owned images.
+ * TODO: This interface is mostly temporary - overlay layers are only
+ *       validated as a whole, with no query for which layers a rejected
+ *       configuration could still present.
  *       We'll also likely want to share swapchain logic (from `io/output.cpp`)
  *       with other systems - most notably screen video capture.
  */
@@ -59,7 +90,20 @@ struct IoOutput
 {
     virtual auto info() -> IoOutputInfo = 0;
     virtual void request_frame() = 0;
-    virtual void commit(GpuImage*, GpuSyncpoint done, Flags<IoOutputCommitFlag>) = 0;
+    virtual auto commit(GpuImage*, GpuSyncpoint done, Flags<IoOutputCommitFlag>, std::span<const IoOutputLayer> layers = {}) -> bool = 0;
+
+    // Checks whether `layers` can be presented together with the output's committed image
+    virtual auto test_layers(std::span<const IoOutputLayer> layers) -> bool { return layers.empty(); }
+
+    // Shows an image of `info().cursor.size` on the cursor plane, or hides the plane if null.
+    // Returns false if the output can't display the image, in which case the plane is left unchanged.
+    virtual auto set_cursor(GpuImage* image, GpuSyncpoint done) -> bool { return !image; }
+
+    // Moves the top-left of the cursor image, in output pixels
+    virtual void move_cursor(vec2i32 position) {}
+
+    // Time between the two most recent page flips, or zero if the backend doesn't report them
+    virtual auto flip_interval() -> std::chrono::nanoseconds { return {}; }
 };
 
 // -----------------------------------------------------------------------------
@@ -31,13 +31,51 @@ void io_output_remove(IoOutputBase* output)
 
 // -----------------------------------------------------------------------------
 
+static constexpr std::chrono::microseconds io_output_commit_margin{1500};
+
+static
+auto get_render_start(IoOutputBase* output, std::chrono::steady_clock::time_point now) -> std::chrono::steady_clock::time_point
+{
+    auto& schedule = output->schedule;
+
+    if (schedule.vrr) return now;
+    if (!schedule.refresh.count() || !schedule.render_estimate.count()) return now;
+
+    auto deadline = schedule.last_vblank + schedule.refresh;
+    if (deadline <= now) {
+        deadline += ((now - deadline) / schedule.refresh + 1) * schedule.refresh;
+    }
+
+    return deadline - schedule.render_estimate - io_output_commit_margin;
+}
+
 void io_output_try_redraw(IoOutputBase* output)
 {
     if (!output->frame_requested) return;
     if (!output->commit_available) return;
     if (!output->size.x || !output->size.y) return;
 
+    auto& schedule = output->schedule;
+    auto now = std::chrono::steady_clock::now();
+
+    if (!std::exchange(schedule.ready, false)) {
+        auto start = get_render_start(output, now);
+        if (start > now) {
+            if (!schedule.timer) {
+                schedule.timer = exec_timer_create(output->io->exec, [output] {
+                    output->schedule.ready = true;
+                    io_output_try_redraw(output);
+                });
+            }
+            exec_timer_set(schedule.timer.get(), start);
+            return;
+        }
+    }
+
+    if (schedule.timer) exec_timer_cancel(schedule.timer.get());
+
     output->frame_requested = false;
+    schedule.frame_start = now;
 
     io_post_event(output->io, ptr_to(IoEvent {
         .output = {
@@ -47,6 +85,42 @@ void io_output_try_redraw(IoOutputBase* output)
     }));
 }
 
+auto IoOutputBase::flip_interval() -> std::chrono::nanoseconds
+{
+    return schedule.last_interval;
+}
+
+void io_output_post_vblank(IoOutputBase* output, std::chrono::steady_clock::time_point time, u32 sequence)
+{
+    auto& schedule = output->schedule;
+
+    // Measure the refresh interval across however many vblanks passed since the last report.
+    // Intervals are meaningless with variable refresh, so keep the last fixed-rate measurement.
+    if (!schedule.vrr && schedule.last_vblank != std::chrono::steady_clock::time_point{} && sequence > schedule.last_sequence) {
+        schedule.refresh = (time - schedule.last_vblank) / (sequence - schedule.last_sequence);
+    }
+
+    if (schedule.last_vblank != std::chrono::steady_clock::time_point{}) {
+        schedule.last_interval = time - schedule.last_vblank;
+    }
+
+    schedule.last_vblank = time;
+    schedule.last_sequence = sequence;
+}
+
+void io_output_post_commit(IoOutputBase* output, GpuSyncpoint done)
+{
+    gpu_wait(done, [output = Weak(output), start = output->schedule.frame_start](u64) {
+        if (!output) return;
+
+        auto& estimate = output->schedule.render_estimate;
+        auto cost = std::chrono::steady_clock::now() - start;
+
+        // Rise immediately to avoid repeated misses, and decay slowly back down
+        estimate = cost > estimate ? cost : estimate - (estimate - cost) / 16;
+    });
+}
+
 void io_output_try_redraw_later(IoOutputBase* output)
 {
     output->try_redraw = output->io->exec->idle.listen([output] {
@@ -256,9 +256,13 @@ void on_present_frame(void* udata, wl_callback*, u32 time)
     }
 }
 
-void IoWaylandOutput::commit(GpuImage* image, GpuSyncpoint done, Flags<IoOutputCommitFlag> flags)
+auto IoWaylandOutput::commit(GpuImage* image, GpuSyncpoint done, Flags<IoOutputCommitFlag> flags, std::span<const IoOutputLayer> layers) -> bool
 {
     debug_assert(commit_available);
+    debug_assert(layers.empty(), "Nested outputs have no overlay planes");
+
+    // Client images are always composited when nested
+    if (flags.contains(IoOutputCommitFlag::scanout)) return false;
 
     auto release = std::ranges::find_if(release_slots, [](auto& s) { return !s.image; });
     if (release == release_slots.end()) {
@@ -298,6 +302,8 @@ void IoWaylandOutput::commit(GpuImage* image, GpuSyncpoint done, Flags<IoOutputC
 
     wl_surface_commit(wl_surface);
     wl_display_flush(io->wayland->wl_display);
+
+    return true;
 }
 
 IoWaylandOutput::~IoWaylandOutput()
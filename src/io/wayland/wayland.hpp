@@ -136,7 +136,7 @@ struct IoWaylandOutput : IoOutputBase
 
     std::vector<ReleaseSlot> release_slots;
 
-    virtual void commit(GpuImage*, GpuSyncpoint done, Flags<IoOutputCommitFlag>) final override;
+    virtual auto commit(GpuImage*, GpuSyncpoint done, Flags<IoOutputCommitFlag>, std::span<const IoOutputLayer>) -> bool final override;
 
     ~IoWaylandOutput();
 };
@@ -1,9 +1,11 @@
 #include "internal.hpp"
 
+#include <core/math.hpp>
+
 static
 auto get_root(SceneNode* node) -> SceneTree*
 {
-    auto* root = dynamic_cast<SceneTree*>(node) ?: node->parent;
+    auto* root = scene_node_cast<SceneTree>(node) ?: node->parent;
     if (!root) return nullptr;
 
     while (root->parent) {
@@ -13,6 +15,12 @@ auto get_root(SceneNode* node) -> SceneTree*
     return root;
 }
 
+auto scene_node_get_scene(SceneNode* node) -> Scene*
+{
+    auto* root = get_root(node);
+    return root ? root->scene : nullptr;
+}
+
 void scene_add_damage_listener(Scene* scene, SceneDamageListener listener)
 {
     scene->damage_listeners.emplace_back(std::move(listener));
@@ -20,18 +28,109 @@ void scene_add_damage_listener(Scene* scene, SceneDamageListener listener)
 
 void scene_node_damage(SceneNode* node)
 {
-    auto* root = get_root(node);
+    auto* scene = scene_node_get_scene(node);
 
-    if (!root || !root->scene) {
+    if (!scene) {
         return;
     }
 
-    node->damage(root->scene);
+    node->damage(scene);
 }
 
-void scene_post_damage(Scene* scene, SceneNode* node)
+// -----------------------------------------------------------------------------
+
+SceneDamageTracker::~SceneDamageTracker()
+{
+    std::erase(scene->damage_trackers, this);
+}
+
+auto scene_damage_tracker_create(Scene* scene) -> Ref<SceneDamageTracker>
+{
+    auto tracker = ref_create<SceneDamageTracker>();
+    tracker->scene = scene;
+    scene->damage_trackers.emplace_back(tracker.get());
+    return tracker;
+}
+
+static
+void tracker_damage(SceneDamageTracker* tracker, aabb2f32 damage)
+{
+    auto& pending = tracker->pending;
+
+    if (pending.contains(damage)) return;
+
+    pending.add(damage);
+
+    // Collapse to bounds once the region becomes too fragmented to be worth tracking precisely
+    if (pending.aabbs.size() > scene_damage_rects_max) {
+        pending = {pending.bounds()};
+    }
+}
+
+void scene_damage_tracker_damage(SceneDamageTracker* tracker, aabb2f32 damage)
+{
+    if (damage.max.x > damage.min.x && damage.max.y > damage.min.y) {
+        tracker_damage(tracker, damage);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static
+auto get_visible_position(SceneNode* node, vec2f32* position) -> bool
+{
+    vec2f32 pos = {};
+    for (auto* tree = node->parent; tree; tree = tree->parent) {
+        if (!tree->enabled) return false;
+        pos += tree->translation;
+    }
+    *position = pos;
+    return true;
+}
+
+auto scene_node_get_bounds(SceneNode* node) -> aabb2f32
+{
+    if (auto* texture = scene_node_cast<SceneTexture>(node)) {
+        return texture->dst;
+    }
+
+    if (auto* mesh = scene_node_cast<SceneMesh>(node); mesh && !mesh->vertices.empty()) {
+        aabb2f32 aabb = {mesh->vertices.front().pos, mesh->vertices.front().pos, minmax};
+        for (auto& vertex : mesh->vertices) {
+            aabb.min = vec_min(aabb.min, vertex.pos);
+            aabb.max = vec_max(aabb.max, vertex.pos);
+        }
+        return {aabb.min + mesh->offset, aabb.max + mesh->offset, minmax};
+    }
+
+    // Input regions have no visual representation
+    return {};
+}
+
+auto scene_node_is_visible(SceneNode* node) -> bool
+{
+    vec2f32 position;
+    return get_visible_position(node, &position);
+}
+
+void scene_post_damage(Scene* scene, SceneNode* node, aabb2f32 bounds)
 {
+    vec2f32 position;
+    if (!scene->damage_trackers.empty() && get_visible_position(node, &position)) {
+        aabb2f32 damage = {position + bounds.min, position + bounds.max, minmax};
+        if (damage.max.x > damage.min.x && damage.max.y > damage.min.y) {
+            for (auto* tracker : scene->damage_trackers) {
+                tracker_damage(tracker, damage);
+            }
+        }
+    }
+
     for (auto& listener : scene->damage_listeners) {
         listener(node);
     }
 }
+
+void scene_post_damage(Scene* scene, SceneNode* node)
+{
+    scene_post_damage(scene, node, scene_node_get_bounds(node));
+}
@@ -0,0 +1,228 @@
+#include "internal.hpp"
+
+#include <core/math.hpp>
+
+// -----------------------------------------------------------------------------
+
+void scene_input_index_update(Scene* scene, SceneInputRegion* region)
+{
+    auto& index = scene->input;
+    if (index.rebuild) return;
+
+    // Regions missing from the index are under disabled trees, and are picked up on rebuild
+    if (auto iter = index.lookup.find(region); iter != index.lookup.end()) {
+        index.stale.emplace_back(iter->second);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static
+auto get_cell_key(vec2i32 cell) -> u64
+{
+    return (u64(u32(cell.x)) << 32) | u32(cell.y);
+}
+
+static
+auto get_cell(vec2f32 pos) -> vec2i32
+{
+    return vec_cast<i32>(vec_floor(pos / scene_input_cell_size));
+}
+
+static
+auto get_hit_bounds(SceneInputRegion* region, vec2f32 origin) -> aabb2f32
+{
+    if (region->region.empty()) return {};
+
+    auto bounds = region->region.bounds();
+
+    aabb2f32 hit;
+    if (!aabb_intersects<f32>(bounds, region->clip, &hit)) return {};
+
+    return {origin + hit.min, origin + hit.max, minmax};
+}
+
+static
+void sorted_insert(std::vector<u32>& indices, u32 i)
+{
+    indices.insert(std::ranges::lower_bound(indices, i), i);
+}
+
+static
+void sorted_erase(std::vector<u32>& indices, u32 i)
+{
+    auto iter = std::ranges::lower_bound(indices, i);
+    if (iter != indices.end() && *iter == i) indices.erase(iter);
+}
+
+template<typename Fn>
+static
+void for_each_cell(const aabb2f32& bounds, Fn&& fn)
+{
+    auto min = get_cell(bounds.min);
+    auto max = get_cell(bounds.max);
+    for (i32 y = min.y; y <= max.y; ++y) {
+        for (i32 x = min.x; x <= max.x; ++x) {
+            fn(get_cell_key({x, y}));
+        }
+    }
+}
+
+static
+void insert_entry(SceneInputIndex& index, u32 i)
+{
+    auto& entry = index.entries[i];
+    auto& bounds = entry.bounds;
+    if (bounds.max.x <= bounds.min.x || bounds.max.y <= bounds.min.y) return;
+
+    // Unbounded and very large regions (e.g. background surfaces) are tested everywhere
+    auto cells = (bounds.max - bounds.min) / scene_input_cell_size;
+    entry.large = !std::isfinite(cells.x) || !std::isfinite(cells.y)
+        || (cells.x + 1) * (cells.y + 1) > scene_input_cells_max;
+
+    if (entry.large) {
+        sorted_insert(index.large, i);
+    } else {
+        for_each_cell(bounds, [&](u64 key) { sorted_insert(index.cells[key], i); });
+    }
+}
+
+static
+void remove_entry(SceneInputIndex& index, u32 i)
+{
+    auto& entry = index.entries[i];
+    auto& bounds = entry.bounds;
+    if (bounds.max.x <= bounds.min.x || bounds.max.y <= bounds.min.y) return;
+
+    if (entry.large) {
+        sorted_erase(index.large, i);
+    } else {
+        for_each_cell(bounds, [&](u64 key) {
+            auto iter = index.cells.find(key);
+            if (iter == index.cells.end()) return;
+            sorted_erase(iter->second, i);
+            if (iter->second.empty()) index.cells.erase(iter);
+        });
+    }
+}
+
+static
+void rebuild_index(Scene* scene)
+{
+    auto& index = scene->input;
+
+    index.entries.clear();
+    index.lookup.clear();
+    index.cells.clear();
+    index.large.clear();
+    index.stale.clear();
+    index.rebuild = false;
+
+    // Positions are accumulated during the walk, instead of being resolved per region
+    std::vector<vec2f32> positions;
+
+    scene_iterate<SceneIterateDirection::front_to_back>(scene->root.get(),
+        [&](SceneTree* tree) {
+            if (!tree->enabled) return SceneIterateAction::skip;
+            positions.emplace_back((positions.empty() ? vec2f32{} : positions.back()) + tree->translation);
+            return SceneIterateAction::next;
+        },
+        [&](SceneNode* node) {
+            if (auto* region = scene_node_cast<SceneInputRegion>(node)) {
+                index.lookup[region] = index.entries.size();
+                index.entries.emplace_back(region, positions.back(), get_hit_bounds(region, positions.back()));
+            }
+        },
+        [&](SceneTree*) {
+            positions.pop_back();
+        });
+
+    for (u32 i = 0; i < index.entries.size(); ++i) {
+        insert_entry(index, i);
+    }
+}
+
+static
+void update_index(Scene* scene)
+{
+    auto& index = scene->input;
+
+    if (index.rebuild) {
+        rebuild_index(scene);
+        return;
+    }
+
+    if (index.stale.empty()) return;
+
+    std::ranges::sort(index.stale);
+    auto duplicates = std::ranges::unique(index.stale);
+    index.stale.erase(duplicates.begin(), duplicates.end());
+
+    for (auto i : index.stale) {
+        auto& entry = index.entries[i];
+        remove_entry(index, i);
+        entry.origin = scene_tree_get_position(entry.region->parent);
+        entry.bounds = get_hit_bounds(entry.region, entry.origin);
+        insert_entry(index, i);
+    }
+
+    index.stale.clear();
+}
+
+// -----------------------------------------------------------------------------
+
+static
+auto is_hit(SceneInputRegion* region, vec2f32 local) -> bool
+{
+    return rect_contains(region->clip, local) && region->region.contains(local);
+}
+
+static
+auto find_input_region_in_tree(SceneTree* tree, vec2f32 pos) -> SceneInputRegion*
+{
+    SceneInputRegion* region = nullptr;
+
+    scene_iterate<SceneIterateDirection::front_to_back>(tree,
+        scene_iterate_default,
+        [&](SceneNode* node) {
+            if (auto input_region = scene_node_cast<SceneInputRegion>(node)) {
+                if (is_hit(input_region, pos - scene_tree_get_position(input_region->parent))) {
+                    region = input_region;
+                    return SceneIterateAction::stop;
+                }
+            }
+            return SceneIterateAction::next;
+        },
+        scene_iterate_default);
+
+    return region;
+}
+
+auto scene_find_input_region_at(SceneTree* tree, vec2f32 pos) -> SceneInputRegion*
+{
+    // Only whole scenes are indexed
+    if (tree->parent || !tree->scene) {
+        return find_input_region_in_tree(tree, pos);
+    }
+
+    auto* scene = tree->scene;
+    auto& index = scene->input;
+
+    update_index(scene);
+
+    static const std::vector<u32> no_entries;
+    auto iter = index.cells.find(get_cell_key(get_cell(pos)));
+    auto& cell = iter != index.cells.end() ? iter->second : no_entries;
+
+    // Merge cell and large entries, front-most first
+    auto a = cell.begin(),        a_end = cell.end();
+    auto b = index.large.begin(), b_end = index.large.end();
+    while (a != a_end || b != b_end) {
+        u32 i = (b == b_end || (a != a_end && *a < *b)) ? *a++ : *b++;
+
+        auto& entry = index.entries[i];
+        if (is_hit(entry.region, pos - entry.origin)) return entry.region;
+    }
+
+    return nullptr;
+}
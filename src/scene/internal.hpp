@@ -6,6 +6,134 @@
 
 // -----------------------------------------------------------------------------
 
+/**
+ * Uniform grid over the world-space bounds of hittable input regions, so that hit tests only
+ * visit regions near the query point. Updated lazily on the next query: regions that moved or
+ * changed shape are re-inserted individually, while structural changes rebuild the index.
+ */
+static constexpr f32 scene_input_cell_size = 256.f;
+static constexpr u32 scene_input_cells_max = 256;
+
+struct SceneInputIndex
+{
+    struct Entry
+    {
+        SceneInputRegion* region;
+        vec2f32  origin; // Position of the region's parent
+        aabb2f32 bounds; // Hittable area in scene coordinates, empty if nothing can be hit
+        bool     large;  // Covers more than `scene_input_cells_max` cells
+    };
+
+    // Input regions under enabled trees, front to back
+    std::vector<Entry> entries;
+    ankerl::unordered_dense::map<SceneInputRegion*, u32> lookup;
+
+    // Entries overlapping each cell, by ascending entry index
+    ankerl::unordered_dense::map<u64, std::vector<u32>> cells;
+    std::vector<u32> large;
+
+    // Entries that moved or changed shape since the last query
+    std::vector<u32> stale;
+
+    // Set when input regions are added, removed, reordered, enabled or disabled
+    bool rebuild = true;
+};
+
+/**
+ * Geometry of a texture or mesh, encoded in scene coordinates together with the draws derived
+ * from it. Packets are re-encoded when their node changes or any of its ancestors moves, so nodes
+ * that didn't change cost nothing between renders.
+ */
+struct ScenePacket
+{
+    SceneNode* node;
+
+    u32 vertex_offset;
+    u32 vertex_count;
+    u32 first_index;
+    u32 index_count;
+    u32 first_draw;
+    u32 draw_count;
+};
+
+/**
+ * A range of indices drawn with the same state. Indices are absolute, so that consecutive
+ * draws sharing state can be merged into one.
+ */
+struct SceneDraw
+{
+    u32 first_index;
+    u32 index_count;
+
+    aabb2f32     clip;   // In scene coordinates
+    GpuImage*    image;
+    GpuSampler*  sampler;
+    GpuBlendMode blend;
+    f32          opacity;
+
+    aabb2f32   bounds;
+    region2f32 opaque; // Pixel aligned area drawn without blending
+    region2f32 blur;   // Area with a blurred backdrop, in scene coordinates
+
+    // Node of the first merged draw, and the range of per-packet draws merged
+    SceneNode* node;
+    u32 first_draw;
+    u32 draw_count;
+};
+
+struct SceneRenderList
+{
+    // Back to front
+    std::vector<ScenePacket> packets;
+
+    std::vector<SceneVertex> vertices;
+    std::vector<u32>         indices;
+    std::vector<SceneDraw>   draws;
+
+    // Changes since the list was last prepared, for refreshing derived state.
+    // `patched` holds packets re-encoded in place, and is unused after a rebuild.
+    bool rebuilt = true;
+    std::vector<u32> patched;
+
+    // `draws` with consecutive draws that share state merged
+    std::vector<SceneDraw> batches;
+
+    // Indices of blurred draws in `draws`
+    std::vector<u32> blurred;
+
+    // Device copies of `vertices` and `indices` for the current render
+    GpuArray<SceneVertex> gpu_vertices;
+    GpuArray<u32>         gpu_indices;
+};
+
+/**
+ * Persistent device copy of the retained list's geometry. Copies are rotated so that one can be
+ * patched while the GPU still reads another, and buffers are only replaced when outgrown.
+ */
+static constexpr u32 scene_copy_pending_max = 64;
+
+struct SceneGeometryCopy
+{
+    Ref<GpuBuffer> vertices;
+    Ref<GpuBuffer> indices;
+
+    u64 last_use = 0; // Submission on the graphics queue that last read the copy
+
+    // Packets re-encoded since the copy was last synced, unless the whole copy is stale
+    std::vector<u32> pending;
+    bool stale = true;
+};
+
+/**
+ * Blurred backdrops are downsampled `scene_blur_levels` times, each level at half the size of the
+ * previous, then upsampled back to the first level. Blurred pixels depend on content up to
+ * `scene_blur_margin` pixels away, so damage repaints blurred textures up to the margin around it, and
+ * the backdrop is blurred for the repainted area plus the margin.
+ */
+static constexpr u32 scene_blur_levels = 3;
+static constexpr i32 scene_blur_margin = 4 << scene_blur_levels;
+static constexpr u32 scene_blur_cache_max = 4;
+
 struct Scene
 {
     Gpu* gpu;
@@ -15,13 +143,92 @@ struct Scene
         Ref<GpuShader> fragment;
         Ref<GpuImage> white;
         Ref<GpuSampler> nearest;
+
+        Ref<GpuRingBuffer> stream;
+
+        SceneRenderStats stats;
+
+        // Dual Kawase blur behind textures, see `SceneTexture::blur`
+        struct {
+            Ref<GpuShader> down;
+            Ref<GpuShader> up;
+            Ref<GpuSampler> linear;
+
+            // Intermediate levels for recently used target sizes, most recent first
+            struct Levels
+            {
+                vec2u32 extent;
+                std::array<Ref<GpuImage>, scene_blur_levels> images;
+            };
+            std::vector<Levels> cache;
+        } blur;
+
+        // Retained packets for the whole scene. Packets are re-encoded individually when their
+        // node or its world state changes, and the list is rebuilt after structural changes.
+        struct {
+            SceneRenderList list;
+            ankerl::unordered_dense::map<SceneNode*, u32> lookup;
+            std::vector<u32> dirty;
+            bool rebuild = true;
+
+            std::vector<SceneGeometryCopy> copies;
+            u32 current;
+        } retained;
     } render;
 
     Ref<SceneTree> root;
 
     std::vector<SceneDamageListener> damage_listeners;
+    std::vector<SceneDamageTracker*> damage_trackers;
+
+    SceneInputIndex input;
 
     ~Scene();
 };
 
 void scene_render_init(Scene*);
+
+// -----------------------------------------------------------------------------
+
+static constexpr u32 scene_damage_history_max = 4;
+static constexpr u32 scene_damage_rects_max   = 16;
+
+// Number of top-most opaque draws used to cull the draws below them
+static constexpr u32 scene_occluders_max = 32;
+
+struct SceneDamageTracker
+{
+    Scene* scene;
+
+    // Damage accumulated since the last render, in scene coordinates
+    region2f32 pending;
+
+    // Damage applied by previous renders, most recent first
+    std::deque<region2f32> history;
+
+    rect2f32 last_viewport;
+
+    ~SceneDamageTracker();
+};
+
+auto scene_node_get_scene(SceneNode*) -> Scene*;
+
+// Visual bounds of a node, in the coordinate space of the node's parent
+auto scene_node_get_bounds(SceneNode*) -> aabb2f32;
+
+// Posts damage for a sub-region of a node, in the coordinate space of the node's parent
+void scene_post_damage(Scene*, SceneNode*, aabb2f32 bounds);
+
+// Marks retained scene state for a full rebuild after nodes under `node` were added, removed,
+// reordered, enabled or disabled
+void scene_node_invalidate_structure(SceneNode*);
+
+// Marks an input region's index entry as stale after it moved or changed shape
+void scene_input_index_update(Scene*, SceneInputRegion*);
+
+// Invalidates the cached world state of a tree node and its descendants, after it moved or was reparented.
+// Packets under the node are marked for re-encoding, as they're encoded in scene coordinates.
+void scene_node_invalidate_world(SceneNode*);
+
+// Marks a texture or mesh's packet for re-encoding after its geometry, appearance or world state changed
+void scene_render_packet_update(SceneNode*);
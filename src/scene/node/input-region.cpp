@@ -9,12 +9,14 @@ SceneInputRegion::~SceneInputRegion()
 
 void SceneInputRegion::damage(Scene* scene)
 {
+    scene_input_index_update(scene, this);
     scene_post_damage(scene, this);
 }
 
 auto scene_input_region_create() -> Ref<SceneInputRegion>
 {
     auto region = ref_create<SceneInputRegion>();
+    region->type = SceneInputRegion::node_type;
 
     return region;
 }
@@ -43,24 +45,3 @@ void scene_input_region_set_clip(SceneInputRegion* input_region, rect2f32 clip)
 
     scene_node_damage(input_region);
 }
-
-auto scene_find_input_region_at(SceneTree* tree, vec2f32 pos) -> SceneInputRegion*
-{
-    SceneInputRegion* region = nullptr;
-
-    scene_iterate<SceneIterateDirection::front_to_back>(tree,
-        scene_iterate_default,
-        [&](SceneNode* node) {
-            if (auto input_region = dynamic_cast<SceneInputRegion*>(node)) {
-                auto local = pos - scene_tree_get_position(input_region->parent);
-                if (rect_contains(input_region->clip, local) && input_region->region.contains(local)) {
-                    region = input_region;
-                    return SceneIterateAction::stop;
-                }
-            }
-            return SceneIterateAction::next;
-        },
-        scene_iterate_default);
-
-    return region;
-}
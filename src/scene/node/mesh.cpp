@@ -3,6 +3,7 @@
 auto scene_mesh_create() -> Ref<SceneMesh>
 {
     auto mesh = ref_create<SceneMesh>();
+    mesh->type = SceneMesh::node_type;
     return mesh;
 }
 
@@ -47,6 +48,8 @@ void scene_mesh_update(SceneMesh* mesh, std::span<const SceneVertex>      vertic
     if (vertices_dirty) update(mesh->vertices, vertices);
     if (indices_dirty)  update(mesh->indices,  indices);
 
+    scene_render_packet_update(mesh);
+
 #if SCENE_NOISY_NODES
     NODE_LOG("scene.mesh{{{}}}.damage()", (void*)mesh);
 #endif
@@ -12,6 +12,8 @@ void scene_node_unparent(SceneNode* node)
     NODE_LOG("scene.node{{{}}}.unparent", (void*)node);
 
     scene_node_damage(node);
+    scene_node_invalidate_structure(node);
     auto parent = std::exchange(node->parent, nullptr);
     debug_assert(std::erase(parent->children, node) == 1);
+    scene_node_invalidate_world(node);
 }
@@ -5,6 +5,7 @@
 auto scene_texture_create() -> Ref<SceneTexture>
 {
     auto texture = ref_create<SceneTexture>();
+    texture->type = SceneTexture::node_type;
     texture->blend = GpuBlendMode::postmultiplied;
     texture->tint = {255, 255, 255, 255};
     texture->src = {{}, {1, 1}, minmax};
@@ -38,6 +39,7 @@ void scene_texture_set_image(SceneTexture* texture, GpuImage* image, GpuSampler*
     texture->image = image;
     texture->sampler = sampler;
     texture->blend = blend;
+    scene_render_packet_update(texture);
 
     if (damage) {
         scene_node_damage(texture);
@@ -51,6 +53,7 @@ void scene_texture_set_tint(SceneTexture* texture, vec4u8 tint)
     NODE_LOG("scene.texture{{{}}}.set_tint{}", (void*)texture, tint);
 
     texture->tint = tint;
+    scene_render_packet_update(texture);
     scene_node_damage(texture);
 }
 
@@ -61,6 +64,7 @@ void scene_texture_set_src(SceneTexture* texture, aabb2f32 source)
     NODE_LOG("scene.texture{{{}}}.set_src{}", (void*)texture, source);
 
     texture->src = source;
+    scene_render_packet_update(texture);
     scene_node_damage(texture);
 }
 
@@ -72,6 +76,35 @@ void scene_texture_set_dst(SceneTexture* texture, rect2f32 dst)
 
     scene_node_damage(texture);
     texture->dst = dst;
+    scene_render_packet_update(texture);
+    scene_node_damage(texture);
+}
+
+void scene_texture_set_opaque(SceneTexture* texture, region2f32 opaque)
+{
+    if (texture->opaque == opaque) return;
+
+    NODE_LOG("scene.texture{{{}}}.set_opaque([{:s}])", (void*)texture,
+        opaque.aabbs
+            | std::views::transform([&](auto& aabb) { return std::format("{}", aabb); })
+            | std::views::join_with(", "sv));
+
+    // Opaque regions only change how content is drawn, not what it looks like
+    texture->opaque = std::move(opaque);
+    scene_render_packet_update(texture);
+}
+
+void scene_texture_set_blur(SceneTexture* texture, region2f32 blur)
+{
+    if (texture->blur == blur) return;
+
+    NODE_LOG("scene.texture{{{}}}.set_blur([{:s}])", (void*)texture,
+        blur.aabbs
+            | std::views::transform([&](auto& aabb) { return std::format("{}", aabb); })
+            | std::views::join_with(", "sv));
+
+    texture->blur = std::move(blur);
+    scene_render_packet_update(texture);
     scene_node_damage(texture);
 }
 
@@ -79,5 +112,27 @@ void scene_texture_damage(SceneTexture* texture, aabb2i32 damage)
 {
     NODE_LOG("scene.texture{{{}}}.damage{}", (void*)texture, rect2i32(damage));
 
-    scene_node_damage(texture);
+    auto* scene = scene_node_get_scene(texture);
+    if (!scene) return;
+
+    if (!texture->image) {
+        scene_post_damage(scene, texture);
+        return;
+    }
+
+    // Map damage from image texels to destination coordinates
+
+    auto extent = vec_cast<f32>(texture->image->extent());
+    auto src = texture->src;
+    auto dst = texture->dst;
+
+    auto to_dst = [&](vec2f32 texel) {
+        return dst.origin + (texel / extent - src.min) / (src.max - src.min) * dst.extent;
+    };
+
+    auto a = to_dst(vec_cast<f32>(damage.min));
+    auto b = to_dst(vec_cast<f32>(damage.max));
+
+    aabb2f32 bounds = {vec_floor(vec_min(a, b)), vec_floor(vec_max(a, b)) + 1.f, minmax};
+    scene_post_damage(scene, texture, aabb_inner(bounds, aabb2f32(dst)));
 }
@@ -8,6 +8,7 @@ SceneTree::~SceneTree()
 
     for (auto& child : children) {
         child->parent = nullptr;
+        scene_node_invalidate_world(child);
     }
 }
 
@@ -21,6 +22,7 @@ void SceneTree::damage(Scene* _scene)
 auto scene_tree_create() -> Ref<SceneTree>
 {
     auto tree = ref_create<SceneTree>();
+    tree->type = SceneTree::node_type;
     tree->enabled = true;
     return tree;
 }
@@ -31,6 +33,8 @@ void scene_tree_set_enabled(SceneTree* tree, bool enabled)
 
     NODE_LOG("scene.tree{{{}}}.set_enabled({})", (void*)tree, enabled);
 
+    scene_node_invalidate_structure(tree);
+
     if (enabled) {
         tree->enabled = true;
         scene_node_damage(tree);
@@ -68,6 +72,7 @@ placed:
 
     // TODO: We only need to damage regions that were visually affected by the rotate
     scene_node_damage(tree);
+    scene_node_invalidate_structure(tree);
 }
 
 static
@@ -78,18 +83,19 @@ void reparent_unsafe(SceneNode* node, SceneTree* tree)
         scene_node_unparent(node);
     }
     node->parent = tree;
+    scene_node_invalidate_world(node);
 }
 
 void scene_tree_place_below(SceneTree* tree, SceneNode* reference, SceneNode* to_place)
 {
-    tree_place(tree, reference, to_place, false);
     reparent_unsafe(to_place, tree);
+    tree_place(tree, reference, to_place, false);
 }
 
 void scene_tree_place_above(SceneTree* tree, SceneNode* reference, SceneNode* to_place)
 {
-    tree_place(tree, reference, to_place, true);
     reparent_unsafe(to_place, tree);
+    tree_place(tree, reference, to_place, true);
 }
 
 void scene_tree_replace(SceneTree* tree, std::span<SceneNode* const> new_children)
@@ -107,9 +113,11 @@ void scene_tree_replace(SceneTree* tree, std::span<SceneNode* const> new_childre
 void scene_tree_clear(SceneTree* tree)
 {
     scene_node_damage(tree);
+    scene_node_invalidate_structure(tree);
 
     for (auto* child : tree->children) {
         child->parent = nullptr;
+        scene_node_invalidate_world(child);
     }
 
     tree->children.clear();
@@ -120,21 +128,99 @@ void scene_tree_set_opacity(SceneTree* tree, f32 opacity)
     if (tree->opacity == opacity) return;
 
     tree->opacity = opacity;
+    scene_node_invalidate_world(tree);
     scene_node_damage(tree);
 }
 
+
 void scene_tree_set_translation(SceneTree* tree, vec2f32 position)
 {
     if (tree->translation == position) return;
 
     NODE_LOG("scene.tree{{{}}}.set_translation{}", (void*)tree, position);
 
+    // Moving a disabled tree has no visible effect
+    if (!tree->enabled) {
+        tree->translation = position;
+        scene_node_invalidate_world(tree);
+        return;
+    }
+
     scene_node_damage(tree);
     tree->translation = position;
+    scene_node_invalidate_world(tree);
     scene_node_damage(tree);
 }
 
+void scene_node_invalidate_world(SceneNode* node)
+{
+    auto* tree = scene_node_cast<SceneTree>(node);
+    if (!tree) {
+        scene_render_packet_update(node);
+        return;
+    }
+
+    // Packets under a dirty tree are already marked, and re-encoding them cleans the tree again
+    if (tree->world.dirty) return;
+
+    tree->world.dirty = true;
+    for (auto* child : tree->children) {
+        scene_node_invalidate_world(child);
+    }
+}
+
+// Resolves the cached world state of a tree and any dirty ancestors
+static
+void update_world(SceneTree* tree)
+{
+    auto& world = tree->world;
+    if (!world.dirty) return;
+
+    if (auto* parent = tree->parent) {
+        update_world(parent);
+        world.position = parent->world.position + tree->translation;
+        world.opacity  = parent->world.opacity  * tree->opacity;
+    } else {
+        world.position = tree->translation;
+        world.opacity  = tree->opacity;
+    }
+    world.dirty = false;
+}
+
 auto scene_tree_get_position(SceneTree* tree) -> vec2f32
 {
-    return tree->translation + (tree->parent ? scene_tree_get_position(tree->parent) : vec2f32{});
+    update_world(tree);
+    return tree->world.position;
+}
+
+auto scene_tree_get_opacity(SceneTree* tree) -> f32
+{
+    update_world(tree);
+    return tree->world.opacity;
+}
+
+auto scene_tree_get_bounds(SceneTree* tree) -> aabb2f32
+{
+    auto origin = scene_tree_get_position(tree);
+
+    aabb2f32 bounds = {};
+    bool empty = true;
+
+    scene_iterate<SceneIterateDirection::back_to_front>(tree,
+        [&](SceneTree* t) {
+            return t == tree || t->enabled
+                ? SceneIterateAction::next
+                : SceneIterateAction::skip;
+        },
+        [&](SceneNode* node) {
+            auto local = scene_node_get_bounds(node);
+            if (local.max.x <= local.min.x || local.max.y <= local.min.y) return;
+
+            auto offset = scene_tree_get_position(node->parent) - origin;
+            aabb2f32 aabb = {offset + local.min, offset + local.max, minmax};
+            bounds = std::exchange(empty, false) ? aabb : aabb_outer(bounds, aabb);
+        },
+        scene_iterate_default);
+
+    return bounds;
 }
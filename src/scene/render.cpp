@@ -5,6 +5,10 @@
 
 #include "scene_render_vert.hpp"
 #include "scene_render_frag.hpp"
+#include "scene_blur_down.hpp"
+#include "scene_blur_up.hpp"
+
+#include "shader/blur.h"
 
 void scene_render_init(Scene* scene)
 {
@@ -31,207 +35,1024 @@ void scene_render_init(Scene* scene)
         .mag = VK_FILTER_NEAREST,
         .min = VK_FILTER_NEAREST,
     });
+
+    scene->render.stream = gpu_ring_buffer_create(scene->gpu, 1 << 20, {});
+
+    scene->render.blur.down = gpu_shader_create(scene->gpu, {
+        .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+        .code  = scene_blur_down,
+        .entry = "main",
+    });
+    scene->render.blur.up = gpu_shader_create(scene->gpu, {
+        .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+        .code  = scene_blur_up,
+        .entry = "main",
+    });
+
+    scene->render.blur.linear = gpu_sampler_create(scene->gpu, {
+        .mag = VK_FILTER_LINEAR,
+        .min = VK_FILTER_LINEAR,
+        .address = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+    });
 }
 
-void scene_render(Scene* scene, GpuImage* target, rect2f32 viewport)
+static
+auto collect_damage(SceneDamageTracker* tracker, rect2f32 viewport, u32 age) -> region2f32
 {
-    auto& render = scene->render;
+    if (!tracker) return {aabb2f32(viewport)};
 
-    struct Draw
-    {
-        u32 vertex_offset;
-        u32 first_index;
-        u32 index_count;
-        aabb2f32 clip;
-        GpuImage* image;
-        GpuSampler* sampler;
-        GpuBlendMode blend;
-        vec2f32 position;
-        f32 opacity;
-    };
+    region2f32 damage = tracker->pending;
 
-    std::vector<SceneVertex> vertices;
-    std::vector<u32> indices;
-    std::vector<Draw> draws;
+    bool full = age == 0
+        || age - 1 > tracker->history.size()
+        || tracker->last_viewport != viewport;
 
-    aabb2f32 default_clip = viewport;
-
-    auto get_opacity = [](SceneNode* node) {
-        f32 opacity = 1.f;
-        while (node->parent) {
-            opacity *= node->parent->opacity;
-            node = node->parent;
+    if (full) {
+        damage = {aabb2f32(viewport)};
+    } else {
+        for (auto& previous : tracker->history | std::views::take(age - 1)) {
+            damage.add(previous);
         }
-        return opacity;
-    };
+    }
 
-    auto get_draw = [&draws, &vertices, &indices](
-        aabb2f32 clip, GpuImage* image, GpuSampler* sampler, GpuBlendMode blend, vec2f32 position, f32 opacity)
-    {
-        auto* draw = draws.empty() ? nullptr : &draws.back();
-        if (  !draw
-            || draw->clip     != clip
-            || draw->image    != image
-            || draw->sampler  != sampler
-            || draw->blend    != blend
-            || draw->position != position
-            || draw->opacity  != opacity)
-        {
-            draw = &draws.emplace_back(Draw{
-                .vertex_offset = u32(vertices.size()),
-                .first_index = u32(indices.size()),
-                .clip = clip,
-                .image = image,
-                .sampler = sampler,
-                .blend = blend,
-                .position = position,
-                .opacity = opacity,
-            });
+    // Record this frame's damage for future buffer ages
+
+    tracker->history.emplace_front(std::move(tracker->pending));
+    if (tracker->history.size() > scene_damage_history_max) {
+        tracker->history.pop_back();
+    }
+    tracker->pending.clear();
+    tracker->last_viewport = viewport;
+
+    return damage;
+}
+
+static
+auto damage_to_scissors(const region2f32& damage, rect2f32 viewport) -> std::vector<rect2i32>
+{
+    std::vector<rect2i32> scissors;
+
+    aabb2i32 bounds = {{INT_MAX, INT_MAX}, {INT_MIN, INT_MIN}, minmax};
+    aabb2i32 limit = {{}, vec_cast<i32>(viewport.extent), minmax};
+
+    // Rects are snapped out to whole pixels and merged, so that scissors stay disjoint even where
+    // damage edges are fractional. Draws are replayed per scissor, and overlap would blend twice.
+    region2i32 pixels;
+    for (auto& aabb : damage.aabbs) {
+        auto local = aabb_inner(aabb, aabb2f32(viewport));
+        pixels.add(aabb_inner(limit, {
+            vec_cast<i32>(vec_floor(local.min - viewport.origin)),
+            vec_cast<i32>(vec_ceil( local.max - viewport.origin)),
+            minmax
+        }));
+    }
+
+    for (auto& aabb : pixels.aabbs) {
+        bounds = aabb_outer(bounds, aabb);
+        scissors.emplace_back(aabb);
+    }
+
+    // Past a point, the cost of replaying draws per rect outweighs the saved fill
+    if (scissors.size() > scene_damage_rects_max) {
+        scissors = {bounds};
+    }
+
+    return scissors;
+}
+
+static
+auto get_opacity(SceneNode* node) -> f32
+{
+    return node->parent ? scene_tree_get_opacity(node->parent) : 1.f;
+}
+
+static
+auto is_opaque(SceneTexture* texture) -> bool
+{
+    if (!texture->image) return false;
+    if (texture->tint != vec4u8{255, 255, 255, 255}) return false;
+    if (get_opacity(texture) != 1.f) return false;
+
+    return texture->blend == GpuBlendMode::none
+        || texture->image->format()->vk_flags.contains(GpuVulkanFormatFlag::ignore_alpha);
+}
+
+static
+auto get_opaque_region(SceneTexture* texture, vec2f32 position) -> region2f32
+{
+    if (!texture->image) return {};
+    if (texture->tint != vec4u8{255, 255, 255, 255}) return {};
+    if (get_opacity(texture) != 1.f) return {};
+
+    aabb2f32 dst = texture->dst;
+
+    region2f32 local;
+    if (is_opaque(texture)) {
+        local = {dst};
+    } else {
+        for (auto& aabb : texture->opaque.aabbs) {
+            aabb2f32 inner;
+            if (aabb_intersects(aabb, dst, &inner)) local.add(inner);
         }
-        return draw;
-    };
+    }
 
-    auto draw_mesh = [&](SceneMesh* mesh) {
-        auto pos = scene_tree_get_position(mesh->parent);
-
-        for (auto& segment : mesh->segments) {
-            draws.emplace_back(Draw {
-                .vertex_offset = u32(vertices.size()) + segment.vertex_offset,
-                .first_index = u32(indices.size()) + segment.first_index,
-                .index_count = u32(segment.index_count),
-                .clip = aabb_inner(default_clip, {
-                    pos + segment.clip.min,
-                    pos + segment.clip.max,
-                    minmax
-                }),
-                .image = segment.image.get() ?: render.white.get(),
-                .sampler = segment.sampler.get() ?: render.nearest.get(),
-                .blend = segment.blend,
-                .position = pos + mesh->offset,
-                .opacity = get_opacity(mesh),
-            });
+    // Partially covered pixels at fractional edges still blend with what's below
+    region2f32 opaque;
+    for (auto& aabb : local.aabbs) {
+        aabb2f32 pixels = {vec_ceil(position + aabb.min), vec_floor(position + aabb.max), minmax};
+        if (pixels.max.x > pixels.min.x && pixels.max.y > pixels.min.y) opaque.add(pixels);
+    }
+    return opaque;
+}
+
+static
+auto get_blur_region(SceneTexture* texture, vec2f32 position) -> region2f32
+{
+    aabb2f32 dst = texture->dst;
+
+    region2f32 blur;
+    for (auto& aabb : texture->blur.aabbs) {
+        aabb2f32 inner;
+        if (aabb_intersects(aabb, dst, &inner)) blur.add({position + inner.min, position + inner.max, minmax});
+    }
+    return blur;
+}
+
+// -----------------------------------------------------------------------------
+
+static
+auto get_packet_size(SceneNode* node, u32* vertex_count, u32* index_count, u32* draw_count) -> bool
+{
+    switch (node->type) {
+        break;case SceneNodeType::texture:
+            *vertex_count = 4;
+            *index_count = 6;
+            *draw_count = 1;
+            return true;
+        break;case SceneNodeType::mesh: {
+            auto* mesh = static_cast<SceneMesh*>(node);
+            *vertex_count = mesh->vertices.size();
+            *index_count = mesh->indices.size();
+            *draw_count = mesh->segments.size();
+            return true;
         }
+        break;case SceneNodeType::tree:
+              case SceneNodeType::input_region:
+            return false;
+    }
+    return false;
+}
 
-        vertices.insert_range(vertices.end(), mesh->vertices);
-        indices.insert_range(indices.end(), mesh->indices);
-    };
+static
+void encode_packet(Scene* scene, SceneRenderList& list, const ScenePacket& packet)
+{
+    auto& render = scene->render;
+
+    auto* vertices = list.vertices.data() + packet.vertex_offset;
+    auto* indices  = list.indices.data()  + packet.first_index;
+    auto* draws    = list.draws.data()    + packet.first_draw;
 
-    auto draw_texture = [&](SceneTexture* texture) {
+    auto pos = scene_tree_get_position(packet.node->parent);
+    auto opacity = get_opacity(packet.node);
+
+    if (auto* texture = scene_node_cast<SceneTexture>(packet.node)) {
         aabb2f32 src = texture->src;
         aabb2f32 dst = texture->dst;
+        dst.min += pos;
+        dst.max += pos;
 
         //  0 ---- 1
         //  | a /  |  a = 0,2,1
         //  |  / b |  b = 1,2,3
         //  2 ---- 3
 
-        auto* draw = get_draw(default_clip,
-            texture->image.get()   ?: render.white.get(),
-            texture->sampler.get() ?: render.nearest.get(),
-            texture->blend,
-            {},
-            get_opacity(texture));
-
-        auto base_vtx = vertices.size() - draw->vertex_offset;
-        draw->index_count += 6;
-        for (auto idx : {0, 2, 1, 1, 2, 3}) {
-            indices.emplace_back(base_vtx + idx);
-        }
-
-        auto translation = scene_tree_get_position(texture->parent);
-        auto push_vtx = [&](vec2f32 pos, vec2f32 uv = {}) {
-            vertices.emplace_back(SceneVertex {
-                .pos = translation + pos,
-                .uv = uv,
-                .color = texture->tint
-            });
+        vertices[0] = {.pos = {dst.min.x, dst.min.y}, .uv = {src.min.x, src.min.y}, .color = texture->tint};
+        vertices[1] = {.pos = {dst.max.x, dst.min.y}, .uv = {src.max.x, src.min.y}, .color = texture->tint};
+        vertices[2] = {.pos = {dst.min.x, dst.max.y}, .uv = {src.min.x, src.max.y}, .color = texture->tint};
+        vertices[3] = {.pos = {dst.max.x, dst.max.y}, .uv = {src.max.x, src.max.y}, .color = texture->tint};
+
+        static constexpr u32 quad[] = {0, 2, 1, 1, 2, 3};
+        for (u32 i = 0; i < 6; ++i) {
+            indices[i] = packet.vertex_offset + quad[i];
+        }
+
+        draws[0] = SceneDraw {
+            .first_index = packet.first_index,
+            .index_count = packet.index_count,
+            .clip = {{-INFINITY, -INFINITY}, {INFINITY, INFINITY}, minmax},
+            .image = texture->image.get()   ?: render.white.get(),
+            .sampler = texture->sampler.get() ?: render.nearest.get(),
+            .blend = texture->blend,
+            .opacity = opacity,
+            .bounds = dst,
+            .opaque = get_opaque_region(texture, pos),
+            .blur = get_blur_region(texture, pos),
+            .node = texture,
+            .first_draw = packet.first_draw,
+            .draw_count = 1,
         };
-        push_vtx({dst.min.x, dst.min.y}, {src.min.x, src.min.y});
-        push_vtx({dst.max.x, dst.min.y}, {src.max.x, src.min.y});
-        push_vtx({dst.min.x, dst.max.y}, {src.min.x, src.max.y});
-        push_vtx({dst.max.x, dst.max.y}, {src.max.x, src.max.y});
+
+    } else if (auto* mesh = scene_node_cast<SceneMesh>(packet.node)) {
+        auto offset = pos + mesh->offset;
+        for (auto[i, vertex] : mesh->vertices | std::views::enumerate) {
+            vertices[i] = vertex;
+            vertices[i].pos += offset;
+        }
+
+        for (auto[i, index] : mesh->indices | std::views::enumerate) {
+            indices[i] = packet.vertex_offset + index;
+        }
+
+        for (auto[i, segment] : mesh->segments | std::views::enumerate) {
+            for (u32 j = 0; j < segment.index_count; ++j) {
+                indices[segment.first_index + j] += segment.vertex_offset;
+            }
+
+            aabb2f32 clip = {pos + segment.clip.min, pos + segment.clip.max, minmax};
+            draws[i] = SceneDraw {
+                .first_index = packet.first_index + segment.first_index,
+                .index_count = segment.index_count,
+                .clip = clip,
+                .image = segment.image.get() ?: render.white.get(),
+                .sampler = segment.sampler.get() ?: render.nearest.get(),
+                .blend = segment.blend,
+                .opacity = opacity,
+                .bounds = clip,
+                .node = mesh,
+                .first_draw = packet.first_draw + u32(i),
+                .draw_count = 1,
+            };
+        }
+    }
+}
+
+static
+void append_packet(Scene* scene, SceneRenderList& list, SceneNode* node)
+{
+    ScenePacket packet {
+        .node = node,
+        .vertex_offset = u32(list.vertices.size()),
+        .first_index = u32(list.indices.size()),
+        .first_draw = u32(list.draws.size()),
     };
+    if (!get_packet_size(node, &packet.vertex_count, &packet.index_count, &packet.draw_count)) return;
+
+    list.vertices.resize(list.vertices.size() + packet.vertex_count);
+    list.indices.resize(list.indices.size() + packet.index_count);
+    list.draws.resize(list.draws.size() + packet.draw_count);
+    encode_packet(scene, list, packet);
+
+    list.packets.emplace_back(packet);
+}
+
+static
+void collect_packets(Scene* scene, SceneRenderList& list, SceneTree* root)
+{
+    list.packets.clear();
+    list.vertices.clear();
+    list.indices.clear();
+    list.draws.clear();
+    list.rebuilt = true;
+    list.patched.clear();
 
     scene_iterate<SceneIterateDirection::back_to_front>(
-        scene->root.get(),
-        scene_iterate_default,
+        root,
+        [&](SceneTree* tree) {
+            // The root is always drawn, so that disabled subtrees can be rendered in isolation
+            return tree == root || tree->enabled
+                ? SceneIterateAction::next
+                : SceneIterateAction::skip;
+        },
         [&](SceneNode* node) {
-            if (auto* texture = dynamic_cast<SceneTexture*>(node)) {
-                draw_texture(texture);
-            } else if (auto* mesh = dynamic_cast<SceneMesh*>(node)) {
-                draw_mesh(mesh);
-            }
+            append_packet(scene, list, node);
         },
         scene_iterate_default);
+}
 
-    auto gpu = scene->gpu;
+void scene_render_packet_update(SceneNode* node)
+{
+    auto* scene = scene_node_get_scene(node);
+    if (!scene) return;
+
+    auto& retained = scene->render.retained;
+    if (retained.rebuild) return;
+
+    // Nodes missing from the list are under disabled trees, and are encoded on rebuild
+    if (auto iter = retained.lookup.find(node); iter != retained.lookup.end()) {
+        retained.dirty.emplace_back(iter->second);
+    }
+}
+
+static
+auto update_retained(Scene* scene) -> SceneRenderList&
+{
+    auto& retained = scene->render.retained;
+
+    auto rebuild = [&] {
+        collect_packets(scene, retained.list, scene->root.get());
+
+        retained.lookup.clear();
+        for (auto[i, packet] : retained.list.packets | std::views::enumerate) {
+            retained.lookup[packet.node] = i;
+        }
+
+        retained.dirty.clear();
+        retained.rebuild = false;
+    };
+
+    if (retained.rebuild) {
+        rebuild();
+        return retained.list;
+    }
+
+    for (auto i : retained.dirty) {
+        auto& packet = retained.list.packets[i];
+
+        // Packets are patched in place, unless a mesh changed size
+        u32 vertex_count, index_count, draw_count;
+        get_packet_size(packet.node, &vertex_count, &index_count, &draw_count);
+        if (vertex_count != packet.vertex_count || index_count != packet.index_count || draw_count != packet.draw_count) {
+            rebuild();
+            break;
+        }
+
+        encode_packet(scene, retained.list, packet);
+        if (!retained.list.rebuilt) retained.list.patched.emplace_back(i);
+    }
+    retained.dirty.clear();
+
+    return retained.list;
+}
+
+static
+auto can_merge(const SceneDraw& a, const SceneDraw& b) -> bool
+{
+    // Blurred draws start their own render segment, see `record`
+    return a.blur.empty() && b.blur.empty()
+        && a.first_index + a.index_count == b.first_index
+        && a.clip    == b.clip
+        && a.image   == b.image
+        && a.sampler == b.sampler
+        && a.blend   == b.blend
+        && a.opacity == b.opacity;
+}
+
+// Merges draws after packets changed
+static
+void merge_draws(SceneRenderList& list)
+{
+    list.batches.clear();
+    list.blurred.clear();
+
+    for (auto[i, draw] : list.draws | std::views::enumerate) {
+        if (!draw.blur.empty()) list.blurred.emplace_back(i);
+
+        if (list.batches.empty() || !can_merge(list.batches.back(), draw)) {
+            list.batches.emplace_back(draw);
+            continue;
+        }
+
+        auto& batch = list.batches.back();
+        batch.index_count += draw.index_count;
+        batch.draw_count++;
+        batch.bounds = aabb_outer(batch.bounds, draw.bounds);
+
+        // Later draws blend over earlier ones, so only their own opaque areas stay opaque where they overlap
+        if (!batch.opaque.empty()) {
+            batch.opaque.subtract({vec_floor(draw.bounds.min), vec_ceil(draw.bounds.max), minmax});
+        }
+        batch.opaque.add(draw.opaque);
+    }
+}
+
+// Returns true if `buffer` was replaced, and its contents are undefined
+static
+auto reserve(Gpu* gpu, Ref<GpuBuffer>& buffer, usz size) -> bool
+{
+    if (buffer && buffer->size >= size) return false;
+    buffer = gpu_buffer_create(gpu, std::bit_ceil(std::max(size, usz(64) << 10)), {});
+    return true;
+}
+
+template<typename T>
+static
+void copy_range(GpuBuffer* buffer, std::span<const T> data, usz first, usz count)
+{
+    std::memcpy(buffer->host<T>(first * sizeof(T)), data.data() + first, count * sizeof(T));
+}
+
+// Brings a copy of the retained list up to date, copying only patched packets where possible
+static
+void sync_copy(Scene* scene, SceneRenderList& list, SceneGeometryCopy& copy)
+{
+    auto vertices = std::span<const SceneVertex>(list.vertices);
+    auto indices  = std::span<const u32>(list.indices);
+
+    if (reserve(scene->gpu, copy.vertices, vertices.size_bytes())) copy.stale = true;
+    if (reserve(scene->gpu, copy.indices,  indices.size_bytes()))  copy.stale = true;
+
+    if (copy.stale || copy.pending.size() > scene_copy_pending_max) {
+        copy_range(copy.vertices.get(), vertices, 0, vertices.size());
+        copy_range(copy.indices.get(),  indices,  0, indices.size());
+    } else {
+        std::ranges::sort(copy.pending);
+        auto duplicates = std::ranges::unique(copy.pending);
+        copy.pending.erase(duplicates.begin(), duplicates.end());
+
+        for (auto i : copy.pending) {
+            auto& packet = list.packets[i];
+            copy_range(copy.vertices.get(), vertices, packet.vertex_offset, packet.vertex_count);
+            copy_range(copy.indices.get(),  indices,  packet.first_index,   packet.index_count);
+        }
+    }
+
+    copy.stale = false;
+    copy.pending.clear();
+}
+
+// Uploads the retained list's geometry, reusing persistent copies between renders
+static
+void upload_retained(Scene* scene, SceneRenderList& list)
+{
+    auto* gpu = scene->gpu;
+    auto& retained = scene->render.retained;
+    auto& copies = retained.copies;
+
+    if (list.rebuilt || !list.patched.empty()) {
+        for (auto& copy : copies) {
+            if (list.rebuilt) copy.stale = true;
+            else              copy.pending.append_range(list.patched);
+        }
+
+        // The current copy is usually still being read by the previous frame, so another is patched
+        auto completed = gpu_syncobj_get_value(gpu->queue.syncobj.get());
+        auto free = std::ranges::find_if(copies, [&](auto& copy) { return copy.last_use <= completed; });
+        retained.current = free != copies.end() ? u32(free - copies.begin()) : u32(copies.size());
+        if (free == copies.end()) copies.emplace_back();
+
+        sync_copy(scene, list, copies[retained.current]);
+    }
+
+    auto& copy = copies[retained.current];
+    copy.last_use = gpu->queue.submitted + 1;
+
+    list.gpu_vertices = {copy.vertices, list.vertices.size()};
+    list.gpu_indices  = {copy.indices,  list.indices.size()};
+}
+
+// Refreshes derived state after packets changed, and uploads geometry for the next render.
+// Lists rendered once are streamed, while the retained list is kept in persistent copies.
+static
+void prepare_list(Scene* scene, SceneRenderList& list, bool retained)
+{
+    if (list.rebuilt || !list.patched.empty()) {
+        merge_draws(list);
+    }
+
+    if (retained) {
+        upload_retained(scene, list);
+    } else {
+        list.gpu_vertices = gpu_ring_buffer_upload(scene->render.stream.get(), std::span<const SceneVertex>(list.vertices));
+        list.gpu_indices  = gpu_ring_buffer_upload(scene->render.stream.get(), std::span<const u32>(list.indices));
+    }
+
+    list.rebuilt = false;
+    list.patched.clear();
+}
+
+// -----------------------------------------------------------------------------
+
+static
+auto get_blur_levels(Scene* scene, vec2u32 extent) -> std::span<const Ref<GpuImage>>
+{
+    auto& cache = scene->render.blur.cache;
+
+    auto iter = std::ranges::find(cache, extent, [](auto& levels) { return levels.extent; });
+    if (iter != cache.end()) {
+        std::ranges::rotate(cache.begin(), iter, iter + 1);
+        return cache.front().images;
+    }
+
+    if (cache.size() >= scene_blur_cache_max) cache.pop_back();
+
+    auto& levels = *cache.emplace(cache.begin());
+    levels.extent = extent;
+    for (auto[i, image] : levels.images | std::views::enumerate) {
+        image = gpu_image_create(scene->gpu, {
+            .extent = vec_max(vec2u32{extent.x >> (i + 1), extent.y >> (i + 1)}, {1, 1}),
+            .format = gpu_format_from_drm(DRM_FORMAT_ABGR8888),
+            .usage = GpuImageUsage::storage | GpuImageUsage::texture,
+        });
+    }
+
+    return levels.images;
+}
+
+// Blurs `areas` of the target (in target pixels) into the first level
+static
+void blur_backdrop(Scene* scene, GpuComputePass* pass, GpuImage* target, std::span<const Ref<GpuImage>> levels, std::span<const aabb2i32> areas)
+{
+    auto* linear = scene->render.blur.linear.get();
+
+    // Every area of a level is written before the next level reads it
+    auto dispatch = [&](GpuImage* src, GpuImage* dst, u32 level) {
+        i32 scale = 2 << level;
+        for (auto& area : areas) {
+            aabb2i32 pixels = aabb_inner<i32>({{}, vec_cast<i32>(dst->extent()), minmax}, {
+                area.min / scale,
+                (area.max + scale - 1) / scale,
+                minmax,
+            });
+            auto extent = pixels.max - pixels.min;
+            if (extent.x <= 0 || extent.y <= 0) continue;
+
+            gpu_push_constants(pass, 0, view_bytes(SceneBlurInput {
+                .src = {src, linear},
+                .dst = {dst, linear},
+                .offset = pixels.min,
+                .extent = extent,
+            }));
+            gpu_dispatch(pass, vec_cast<u32>((extent + SCENE_BLUR_GROUP_SIZE - 1) / SCENE_BLUR_GROUP_SIZE));
+
+            scene->render.stats.dispatches++;
+        }
+        gpu_barrier(pass);
+    };
+
+    gpu_bind_shader(pass, scene->render.blur.down.get());
+    for (u32 i = 0; i < levels.size(); ++i) {
+        dispatch(i ? levels[i - 1].get() : target, levels[i].get(), i);
+    }
+
+    // Upsampling overwrites the larger levels, leaving the result in the first
+    gpu_bind_shader(pass, scene->render.blur.up.get());
+    for (u32 i = levels.size() - 1; i-- > 0;) {
+        dispatch(levels[i + 1].get(), levels[i].get(), i);
+    }
+}
+
+static
+void record(Scene* scene, const SceneRenderList& list, GpuImage* target, rect2f32 viewport, std::span<const rect2i32> scissors, vec4f32 clear_color,
+            std::span<SceneTexture* const> exclude)
+{
+    auto& render = scene->render;
+    render.stats = {};
+
+    bool full = scissors.size() == 1 && scissors.front() == rect2i32{{}, vec_cast<i32>(viewport.extent), xywh};
+
+    // Backdrops are blurred from the target itself
+    bool can_blur = target->usage().contains(GpuImageUsage::texture);
+
+    aabb2f32 default_clip = viewport;
+
+    // Batches containing excluded textures are drawn as their individual draws instead
 
-    auto make_gpu = [&]<typename T>(std::span<T> data) {
-        GpuArray<T> arr{gpu_buffer_create(gpu, data.size_bytes(), {}), 0};
-        std::memcpy(arr.host(), data.data(), data.size_bytes());
-        return arr;
+    auto is_excluded = [&](const SceneDraw& draw) {
+        return std::ranges::contains(exclude, draw.node);
     };
 
-    auto gpu_vertices = make_gpu(std::span(vertices));
-    auto gpu_indices  = make_gpu(std::span(indices));
+    std::vector<const SceneDraw*> draws;
+    draws.reserve(list.batches.size());
+    for (auto& batch : list.batches) {
+        auto members = std::span(list.draws).subspan(batch.first_draw, batch.draw_count);
+        if (exclude.empty() || std::ranges::none_of(members, is_excluded)) {
+            draws.emplace_back(&batch);
+            continue;
+        }
+        for (auto& draw : members) {
+            if (!is_excluded(draw)) draws.emplace_back(&draw);
+        }
+    }
+
+    // Opaque draws hide everything below them. Only the top-most are tracked,
+    // as those are the most likely to cover the rest of the scene.
+
+    struct Occluder
+    {
+        usz      draw;
+        aabb2f32 bounds;
+    };
+
+    std::vector<Occluder> occluders;
+    for (usz i = draws.size(); i-- > 0 && occluders.size() < scene_occluders_max;) {
+        for (auto& aabb : draws[i]->opaque.aabbs) {
+            aabb2f32 bounds;
+            if (aabb_intersects(aabb, default_clip, &bounds)) {
+                occluders.emplace_back(i, bounds);
+            }
+        }
+    }
+
+    auto is_occluded = [&](usz draw, aabb2f32 visible) {
+        region2f32 remaining = {visible};
+        for (auto& occluder : occluders) {
+            if (occluder.draw <= draw) break;
+            remaining.subtract(occluder.bounds);
+            if (remaining.empty()) return true;
+        }
+        return false;
+    };
+
+    // Blurred draws sample everything drawn below them, so recording is split into segments that
+    // end before each blurred draw, with its backdrop blurred in between
+
+    aabb2f32 repaint = {{INFINITY, INFINITY}, {-INFINITY, -INFINITY}, minmax};
+    for (auto scissor : scissors) {
+        aabb2f32 damaged = rect_cast<f32>(scissor);
+        repaint = aabb_outer(repaint, {damaged.min + viewport.origin, damaged.max + viewport.origin, minmax});
+    }
+
+    std::vector<usz> blurred;
+    if (can_blur && !list.blurred.empty()) {
+        for (auto[i, draw] : draws | std::views::enumerate) {
+            aabb2f32 visible;
+            if (draw->blur.empty()) continue;
+            if (!aabb_intersects(draw->blur.bounds(), repaint, &visible)) continue;
+            if (is_occluded(i, visible)) continue;
+            blurred.emplace_back(i);
+        }
+    }
 
-    gpu_protect(gpu, gpu_vertices.buffer.get());
-    gpu_protect(gpu, gpu_indices.buffer.get());
+    auto gpu = scene->gpu;
+
+    // Backdrop quads cover the bounds of each blurred draw, and sample the first blur level.
+    // They are only drawn within the blurred area.
+
+    std::span<const Ref<GpuImage>> levels;
+    std::vector<SceneVertex> backdrop_vertices;
+    std::vector<u32>         backdrop_indices;
+
+    if (!blurred.empty()) {
+        levels = get_blur_levels(scene, target->extent());
+
+        // Target pixels covered by the first level
+        auto covered = vec_cast<f32>(levels[0]->extent()) * 2.f;
+        auto to_uv = [&](vec2f32 pos) { return (pos - viewport.origin) / covered; };
+
+        for (auto i : blurred) {
+            auto& bounds = draws[i]->bounds;
+            vec4u8 color = {255, 255, 255, 255};
+            u32 base = backdrop_vertices.size();
+            backdrop_vertices.push_back({.pos = {bounds.min.x, bounds.min.y}, .uv = to_uv({bounds.min.x, bounds.min.y}), .color = color});
+            backdrop_vertices.push_back({.pos = {bounds.max.x, bounds.min.y}, .uv = to_uv({bounds.max.x, bounds.min.y}), .color = color});
+            backdrop_vertices.push_back({.pos = {bounds.min.x, bounds.max.y}, .uv = to_uv({bounds.min.x, bounds.max.y}), .color = color});
+            backdrop_vertices.push_back({.pos = {bounds.max.x, bounds.max.y}, .uv = to_uv({bounds.max.x, bounds.max.y}), .color = color});
+            for (u32 index : {0, 2, 1, 1, 2, 3}) {
+                backdrop_indices.push_back(base + index);
+            }
+        }
+    }
+
+    auto gpu_backdrop_vertices = gpu_ring_buffer_upload(render.stream.get(), std::span<const SceneVertex>(backdrop_vertices));
+    auto gpu_backdrop_indices  = gpu_ring_buffer_upload(render.stream.get(), std::span<const u32>(backdrop_indices));
 
-    // Protect images
+    // Protect images and retained geometry
+    //
+    // Only the underlying images are protected, leases are released as soon as the scene drops them.
+    // Lessors are responsible for ordering reuse after `GpuImage::last_use`.
 
     gpu_protect(gpu, render.white.get());
-    for (auto& draw : draws) {
-        gpu_protect(gpu, draw.image);
+    for (auto* draw : draws) {
+        gpu_protect(gpu, draw->image->base());
     }
+    for (auto& level : levels) {
+        gpu_protect(gpu, level.get());
+    }
+    gpu_protect(gpu, list.gpu_vertices.buffer.get());
+    gpu_protect(gpu, list.gpu_indices.buffer.get());
 
     // Record
 
-    gpu_render(gpu, {
-        .target = target,
-        .clear_color = {{0,0,0,1}},
-    }, [&](GpuRenderPass* pass) {
-        gpu_set_viewports(pass, {{{{}, vec_cast<f32>(target->extent()), xywh}}});
+    // Geometry is in scene coordinates
+    auto draw_scale = 2.f / viewport.extent;
+    auto draw_offset = -viewport.origin * draw_scale - 1.f;
+
+    // Draws `draws[begin, end)`, preceded by the backdrop of `draws[begin]` if it is blurred
+    auto record_segment = [&](usz begin, usz end, bool first, std::optional<usz> backdrop) {
+        gpu_render(gpu, {
+            .target = target,
+            .clear_color = first && full ? std::optional(clear_color) : std::nullopt,
+        }, [&](GpuRenderPass* pass) {
+            gpu_set_viewports(pass, {{{{}, vec_cast<f32>(target->extent()), xywh}}});
+
+            if (first && !full) {
+                gpu_clear(pass, clear_color, scissors);
+            }
+
+            gpu_bind_shaders(pass, {{scene->render.vertex.get(), scene->render.fragment.get()}});
+            gpu_bind_index_buffer(pass, list.gpu_indices.buffer.get(), list.gpu_indices.byte_offset, VK_INDEX_TYPE_UINT32);
+
+            std::optional<GpuBlendMode> current_blend;
+            std::optional<rect2i32>     current_scissor;
+
+            auto emit = [&](const SceneDraw& draw, const SceneVertex* vertices, GpuBlendMode blend, rect2i32 scissor) {
+                if (current_blend != blend) {
+                    gpu_set_blend_state(pass, {{blend}});
+                    current_blend = blend;
+                }
+                if (current_scissor != scissor) {
+                    gpu_set_scissors(pass, {{scissor}});
+                    current_scissor = scissor;
+                }
+
+                rect2f32 clip = aabb_inner(default_clip, draw.clip);
+                clip.extent /= 2.f;
+                clip.origin += clip.extent - viewport.origin;
+
+                u32 flags = 0;
+                if (draw.blend == GpuBlendMode::premultiplied) {
+                    flags |= SCENE_DRAW_FLAG_PREMULTIPLIED;
+                }
+
+                gpu_push_constants(pass, 0, view_bytes(SceneRenderInput {
+                    .vertices = vertices,
+                    .scale = draw_scale,
+                    .offset = draw_offset,
+                    .texture = {draw.image, draw.sampler},
+                    .clip = clip,
+                    .opacity = draw.opacity,
+                    .flags = flags,
+                }));
 
-        rect2f32 scissor = default_clip;
-        scissor.origin -= viewport.origin;
-        gpu_set_scissors(pass, {{rect_cast<i32>(scissor)}});
+                gpu_draw_indexed(pass, {
+                    .index_count = draw.index_count,
+                    .instance_count = 1,
+                    .first_index = draw.first_index,
+                    .vertex_offset = 0,
+                    .first_instance = 0
+                });
 
-        gpu_set_blend_state(pass, {{GpuBlendMode::premultiplied}});
+                render.stats.draws++;
+                render.stats.vertices += draw.index_count;
+            };
 
-        gpu_bind_shaders(pass, {{scene->render.vertex.get(), scene->render.fragment.get()}});
-        gpu_bind_index_buffer(pass, gpu_indices.buffer.get(), 0, VK_INDEX_TYPE_UINT32);
+            // Pixels of a damaged rect covered by `area`, in target pixels
+            auto to_pixels = [&](aabb2f32 area, rect2i32 limit) -> aabb2i32 {
+                return aabb_inner<i32>(limit, {
+                    vec_cast<i32>(vec_floor(area.min - viewport.origin)),
+                    vec_cast<i32>(vec_ceil( area.max - viewport.origin)),
+                    minmax,
+                });
+            };
 
-        for (auto& draw : draws) {
+            for (auto scissor : scissors) {
+                aabb2f32 damaged = rect_cast<f32>(scissor);
+                damaged.min += viewport.origin;
+                damaged.max += viewport.origin;
 
-            rect2f32 clip = draw.clip;
-            clip.extent /= 2.f;
-            clip.origin += clip.extent - viewport.origin;
+                if (backdrop) {
+                    auto& draw = *draws[begin];
 
-            auto draw_scale = 2.f / viewport.extent;
+                    SceneDraw quad {
+                        .first_index = u32(*backdrop * 6),
+                        .index_count = 6,
+                        .clip = default_clip,
+                        .image = levels[0].get(),
+                        .sampler = render.blur.linear.get(),
+                        .blend = GpuBlendMode::premultiplied,
+                        .opacity = 1.f,
+                    };
 
-            u32 flags = 0;
-            if (draw.blend == GpuBlendMode::premultiplied) {
-                flags |= SCENE_DRAW_FLAG_PREMULTIPLIED;
+                    // Opaque areas of the draw hide its backdrop
+                    aabb2f32 visible;
+                    if (aabb_intersects(draw.bounds, damaged, &visible) && !is_occluded(begin, visible)) {
+                        region2f32 behind = draw.blur;
+                        behind.intersect(visible);
+                        behind.subtract(draw.opaque);
+
+                        region2i32 pixels;
+                        for (auto& part : behind.aabbs) {
+                            pixels.add(to_pixels(part, scissor));
+                        }
+
+                        gpu_bind_index_buffer(pass, gpu_backdrop_indices.buffer.get(), gpu_backdrop_indices.byte_offset, VK_INDEX_TYPE_UINT32);
+                        for (auto& part : pixels.aabbs) {
+                            emit(quad, gpu_backdrop_vertices.device(), GpuBlendMode::none, part);
+                        }
+                        gpu_bind_index_buffer(pass, list.gpu_indices.buffer.get(), list.gpu_indices.byte_offset, VK_INDEX_TYPE_UINT32);
+                    }
+                }
+
+                for (usz i = begin; i < end; ++i) {
+                    auto& draw = *draws[i];
+
+                    aabb2f32 visible;
+                    if (!aabb_intersects(draw.bounds, damaged, &visible)) continue;
+                    if (is_occluded(i, visible)) continue;
+
+                    if (draw.opaque.empty()) {
+                        emit(draw, list.gpu_vertices.device(), GpuBlendMode::premultiplied, scissor);
+                        continue;
+                    }
+
+                    // Opaque areas are written directly, skipping the blend with the destination.
+                    // Blended parts exclude every pixel already written, so none is blended twice.
+                    region2i32 blended = to_pixels(visible, scissor);
+                    for (auto& aabb : draw.opaque.aabbs) {
+                        aabb2f32 part;
+                        if (!aabb_intersects(aabb, visible, &part)) continue;
+                        auto pixels = to_pixels(part, scissor);
+                        emit(draw, list.gpu_vertices.device(), GpuBlendMode::none, pixels);
+                        blended.subtract(pixels);
+                    }
+                    for (auto& part : blended.aabbs) {
+                        emit(draw, list.gpu_vertices.device(), GpuBlendMode::premultiplied, part);
+                    }
+                }
             }
+        });
+    };
 
-            gpu_push_constants(pass, 0, view_bytes(SceneRenderInput {
-                .vertices = gpu_vertices.device(),
-                .scale = draw_scale,
-                .offset = (draw.position - viewport.origin) * draw_scale - 1.f,
-                .texture = {draw.image, draw.sampler},
-                .clip = clip,
-                .opacity = draw.opacity,
-                .flags = flags,
-            }));
+    record_segment(0, blurred.empty() ? draws.size() : blurred.front(), true, std::nullopt);
 
-            gpu_draw_indexed(pass, {
-                .index_count = draw.index_count,
-                .instance_count = 1,
-                .first_index = draw.first_index,
-                .vertex_offset = draw.vertex_offset,
-                .first_instance = 0
-            });
+    for (auto[k, i] : blurred | std::views::enumerate) {
+        // Only repainted pixels of the blurred area need a backdrop, and those sample up to the margin around them
+        aabb2i32 limit = {{}, vec_cast<i32>(target->extent()), minmax};
+        region2i32 area;
+        for (auto& aabb : draws[i]->blur.aabbs) {
+            aabb2i32 pixels = {
+                vec_cast<i32>(vec_floor(aabb.min - viewport.origin)),
+                vec_cast<i32>(vec_ceil( aabb.max - viewport.origin)),
+                minmax,
+            };
+            for (auto scissor : scissors) {
+                aabb2i32 part;
+                if (!aabb_intersects(pixels, aabb2i32(scissor), &part)) continue;
+                area.add(aabb_inner(limit, {part.min - scene_blur_margin, part.max + scene_blur_margin, minmax}));
+            }
         }
-    });
+
+        gpu_compute(gpu, [&](GpuComputePass* pass) {
+            blur_backdrop(scene, pass, target, levels, area.aabbs);
+        });
+
+        usz end = usz(k) + 1 < blurred.size() ? blurred[k + 1] : draws.size();
+        record_segment(i, end, false, k);
+    }
+}
+
+// Repaints the part of each blurred area whose backdrop samples damaged content
+static
+void expand_blur_damage(const SceneRenderList& list, region2f32& damage, std::span<SceneTexture* const> exclude)
+{
+    std::vector<aabb2f32> blurred;
+    for (auto i : list.blurred) {
+        auto& draw = list.draws[i];
+        if (std::ranges::contains(exclude, draw.node)) continue;
+        blurred.append_range(draw.blur.aabbs);
+    }
+
+    // Repainted areas can reach further blurred textures, so this repeats until none are added
+    for (bool changed = !blurred.empty(); changed;) {
+        changed = false;
+        for (auto& bounds : blurred) {
+            region2f32 resampled;
+            for (auto& aabb : damage.aabbs) {
+                aabb2f32 part;
+                if (aabb_intersects({aabb.min - f32(scene_blur_margin), aabb.max + f32(scene_blur_margin), minmax}, bounds, &part)) {
+                    resampled.add(part);
+                }
+            }
+            for (auto& part : resampled.aabbs) {
+                if (damage.contains(part)) continue;
+                damage.add(part);
+                changed = true;
+            }
+        }
+    }
+}
+
+void scene_render(Scene* scene, GpuImage* target, rect2f32 viewport, SceneDamageTracker* tracker, u32 age,
+                  std::span<SceneTexture* const> exclude)
+{
+    auto& list = update_retained(scene);
+    prepare_list(scene, list, true);
+
+    auto damage = collect_damage(tracker, viewport, age);
+    if (target->usage().contains(GpuImageUsage::texture)) {
+        expand_blur_damage(list, damage, exclude);
+    }
+    auto scissors = damage_to_scissors(damage, viewport);
+
+    if (scissors.empty()) {
+        // Target contents are already up to date
+        scene->render.stats = {};
+        gpu_protect(scene->gpu, target);
+        return;
+    }
+
+    record(scene, list, target, viewport, scissors, {0, 0, 0, 1}, exclude);
+}
+
+void scene_render_tree(SceneTree* tree, GpuImage* target, rect2f32 viewport)
+{
+    auto* scene = scene_node_get_scene(tree);
+    debug_assert(scene);
+
+    // Subtrees are rarely rendered on their own, so they're encoded from scratch
+    SceneRenderList list;
+    collect_packets(scene, list, tree);
+    prepare_list(scene, list, false);
+
+    record(scene, list, target, viewport, {{{{}, vec_cast<i32>(viewport.extent), xywh}}}, {}, {});
+}
+
+auto scene_get_render_stats(Scene* scene) -> const SceneRenderStats&
+{
+    return scene->render.stats;
+}
+
+// -----------------------------------------------------------------------------
+
+auto scene_find_scanout(Scene* scene, rect2f32 viewport) -> SceneTexture*
+{
+    SceneTexture* found = nullptr;
+
+    scene_iterate<SceneIterateDirection::front_to_back>(
+        scene->root.get(),
+        scene_iterate_default,
+        [&](SceneNode* node) {
+            auto bounds = scene_node_get_bounds(node);
+            auto position = scene_tree_get_position(node->parent);
+            aabb2f32 world = {position + bounds.min, position + bounds.max, minmax};
+
+            if (!aabb_intersects(world, aabb2f32(viewport))) return SceneIterateAction::next;
+
+            // Only the top-most visible node can be scanned out
+            auto* texture = scene_node_cast<SceneTexture>(node);
+            if (texture
+                    && world == aabb2f32(viewport)
+                    && texture->src == aabb2f32{{}, {1, 1}, minmax}
+                    && is_opaque(texture)) {
+                found = texture;
+            }
+
+            return SceneIterateAction::stop;
+        },
+        scene_iterate_default);
+
+    return found;
+}
+
+static
+auto is_overlay_candidate(SceneTexture* texture, aabb2f32 world, rect2f32 viewport, const GpuFormatSet* formats) -> bool
+{
+    auto* image = texture->image.get();
+    if (!image) return false;
+
+    // Only client dmabufs with an explicit modifier can be handed to an output
+    if (image->modifier() == DRM_FORMAT_MOD_INVALID) return false;
+    if (!formats->get(image->format()).contains(image->modifier())) return false;
+
+    // Planes can't apply tints, fades or cropping
+    if (texture->tint != vec4u8{255, 255, 255, 255}) return false;
+    if (get_opacity(texture) != 1.f) return false;
+    if (texture->src != aabb2f32{{}, {1, 1}, minmax}) return false;
+
+    // Planes blend with premultiplied alpha
+    if (texture->blend != GpuBlendMode::premultiplied && !is_opaque(texture)) return false;
+
+    // Must be pixel aligned and fully inside the output
+    aabb2f32 local = {world.min - viewport.origin, world.max - viewport.origin, minmax};
+    if (local.min != vec_round(local.min) || local.max != vec_round(local.max)) return false;
+    if (aabb_inner(world, aabb2f32(viewport)) != world) return false;
+
+    return true;
+}
+
+auto scene_find_overlays(Scene* scene, rect2f32 viewport, const GpuFormatSet* formats, u32 max) -> std::vector<SceneTexture*>
+{
+    std::vector<SceneTexture*> found;
+    if (!max) return found;
+
+    // Bounds of visible nodes above the current node
+    std::vector<aabb2f32> above;
+
+    scene_iterate<SceneIterateDirection::front_to_back>(
+        scene->root.get(),
+        scene_iterate_default,
+        [&](SceneNode* node) {
+            auto bounds = scene_node_get_bounds(node);
+            auto position = scene_tree_get_position(node->parent);
+            aabb2f32 world = {position + bounds.min, position + bounds.max, minmax};
+
+            if (!aabb_intersects(world, aabb2f32(viewport))) return SceneIterateAction::next;
+
+            // Overlays are presented above everything that is composited, so a texture can
+            // only be promoted if nothing above it overlaps it.
+            auto* texture = scene_node_cast<SceneTexture>(node);
+            if (texture
+                    && is_overlay_candidate(texture, world, viewport, formats)
+                    && std::ranges::none_of(above, [&](auto& aabb) { return aabb_intersects(aabb, world); })) {
+                found.emplace_back(texture);
+                if (found.size() == max) return SceneIterateAction::stop;
+            }
+
+            above.emplace_back(world);
+
+            return SceneIterateAction::next;
+        },
+        scene_iterate_default);
+
+    return found;
 }
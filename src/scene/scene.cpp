@@ -22,3 +22,11 @@ auto scene_get_root(Scene* scene) -> SceneTree*
 {
     return scene->root.get();
 }
+
+void scene_node_invalidate_structure(SceneNode* node)
+{
+    if (auto* scene = scene_node_get_scene(node)) {
+        scene->input.rebuild = true;
+        scene->render.retained.rebuild = true;
+    }
+}
@@ -21,7 +21,52 @@ auto scene_get_root(Scene*) -> SceneTree*;
 
 // -----------------------------------------------------------------------------
 
-void scene_render(Scene*, GpuImage* target, rect2f32 viewport);
+/**
+ * Accumulates damage for a single render target (usually an output).
+ *
+ * When passed to `scene_render` together with the age of the target image, only
+ * areas damaged since the target was last rendered to will be repainted.
+ */
+struct SceneDamageTracker;
+
+auto scene_damage_tracker_create(Scene*) -> Ref<SceneDamageTracker>;
+
+// Adds damage in scene coordinates, for changes that happen outside of the scene graph
+void scene_damage_tracker_damage(SceneDamageTracker*, aabb2f32 damage);
+
+// -----------------------------------------------------------------------------
+
+void scene_render(Scene*, GpuImage* target, rect2f32 viewport, SceneDamageTracker* = nullptr, u32 age = 0,
+                  std::span<SceneTexture* const> exclude = {});
+
+// Renders a subtree in isolation over a transparent background, even if the subtree itself is disabled
+void scene_render_tree(SceneTree*, GpuImage* target, rect2f32 viewport);
+
+struct SceneRenderStats
+{
+    u32 draws;      // Draw calls, counting repeats for each scissor
+    u32 vertices;   // Vertices processed, counting each index drawn
+    u32 dispatches; // Compute dispatches for blurred backdrops
+};
+
+// Counters for the most recent `scene_render` or `scene_render_tree`
+auto scene_get_render_stats(Scene*) -> const SceneRenderStats&;
+
+/**
+ * Finds a texture that can be presented directly in place of rendering `viewport`.
+ *
+ * The texture must be the top-most visible node in the viewport, cover it exactly, and be opaque.
+ * Callers are responsible for checking that the texture's image is compatible with the output.
+ */
+auto scene_find_scanout(Scene*, rect2f32 viewport) -> SceneTexture*;
+
+/**
+ * Finds up to `max` textures in `viewport` that can be presented on overlay planes, top-most first.
+ *
+ * Textures must be dmabufs in `formats`, pixel-aligned, untransformed, and not overlapped by any
+ * visible node above them. Callers should `exclude` the textures they present from `scene_render`.
+ */
+auto scene_find_overlays(Scene*, rect2f32 viewport, const GpuFormatSet* formats, u32 max) -> std::vector<SceneTexture*>;
 
 // -----------------------------------------------------------------------------
 
@@ -30,17 +75,29 @@ void scene_add_damage_listener(Scene*, SceneDamageListener);
 
 // -----------------------------------------------------------------------------
 
+enum class SceneNodeType : u8
+{
+    tree,
+    texture,
+    mesh,
+    input_region,
+};
+
 struct SceneNode
 {
     SceneTree* parent;
 
+    // Set on creation, allows dispatching on node kinds without RTTI
+    SceneNodeType type;
+
     virtual ~SceneNode();
 
     virtual void damage(Scene*) = 0;
 };
 
-void scene_node_unparent(SceneNode*);
-void scene_node_damage(  SceneNode*);
+void scene_node_unparent(  SceneNode*);
+void scene_node_damage(    SceneNode*);
+auto scene_node_is_visible(SceneNode*) -> bool;
 
 void scene_post_damage(Scene*, SceneNode*);
 
@@ -48,6 +105,8 @@ void scene_post_damage(Scene*, SceneNode*);
 
 struct SceneTree : SceneNode
 {
+    static constexpr auto node_type = SceneNodeType::tree;
+
     Scene* scene;
 
     bool enabled;
@@ -55,6 +114,14 @@ struct SceneTree : SceneNode
 
     vec2f32 translation;
 
+    // Position and opacity accumulated from the root, resolved on demand.
+    // A dirty tree implies that all of its descendant trees are dirty too.
+    struct {
+        vec2f32 position;
+        f32     opacity;
+        bool    dirty = true;
+    } world;
+
     struct {
         Uid   id;
         void* data;
@@ -76,14 +143,20 @@ void scene_tree_replace(    SceneTree*, std::span<SceneNode* const> children);
 void scene_tree_clear(      SceneTree*);
 
 void scene_tree_set_opacity(SceneTree*, f32 opacity);
+auto scene_tree_get_opacity(SceneTree*) -> f32; // Accumulated opacity, including all ancestors
 
 void scene_tree_set_translation(SceneTree*, vec2f32 translation);
 auto scene_tree_get_position(   SceneTree*) -> vec2f32;
 
+// Visual bounds of all enabled descendants, relative to the tree's position
+auto scene_tree_get_bounds(SceneTree*) -> aabb2f32;
+
 // -----------------------------------------------------------------------------
 
 struct SceneInputRegion : SceneNode
 {
+    static constexpr auto node_type = SceneNodeType::input_region;
+
     region2f32 region = {{{-INFINITY, -INFINITY}, {INFINITY, INFINITY}, minmax}};
     rect2f32   clip;
 
@@ -101,6 +174,8 @@ auto scene_find_input_region_at(SceneTree*, vec2f32 pos) -> SceneInputRegion*;
 
 struct SceneTexture : SceneNode
 {
+    static constexpr auto node_type = SceneNodeType::texture;
+
     Ref<GpuImage>   image;
     Ref<GpuSampler> sampler;
     GpuBlendMode   blend;
@@ -109,6 +184,13 @@ struct SceneTexture : SceneNode
     aabb2f32 src;
     rect2f32 dst;
 
+    // Area known to be opaque regardless of the image's alpha, in the same space as `dst`
+    region2f32 opaque;
+
+    // Area whose backdrop is blurred below translucent parts of the texture, in the same space as `dst`.
+    // Only takes effect if the render target can be sampled.
+    region2f32 blur;
+
     virtual void damage(Scene*);
 
     ~SceneTexture();
@@ -119,6 +201,8 @@ void scene_texture_set_image(SceneTexture*, GpuImage*, GpuSampler*, GpuBlendMode
 void scene_texture_set_tint( SceneTexture*, vec4u8   tint);
 void scene_texture_set_src(  SceneTexture*, aabb2f32 src);
 void scene_texture_set_dst(  SceneTexture*, rect2f32 dst);
+void scene_texture_set_opaque(SceneTexture*, region2f32 opaque);
+void scene_texture_set_blur(  SceneTexture*, region2f32 blur);
 void scene_texture_damage(   SceneTexture*, aabb2i32 damage);
 
 // -----------------------------------------------------------------------------
@@ -138,6 +222,8 @@ struct SceneMeshSegment
 
 struct SceneMesh : SceneNode
 {
+    static constexpr auto node_type = SceneNodeType::mesh;
+
     vec2f32 offset;
 
     std::vector<SceneVertex>      vertices;
@@ -157,6 +243,15 @@ void scene_mesh_update(SceneMesh*, std::span<const SceneVertex>      vertices,
 
 // -----------------------------------------------------------------------------
 
+// Checked downcast, returns null if `node` is not a `T`
+template<typename T>
+auto scene_node_cast(SceneNode* node) -> T*
+{
+    return node && node->type == T::node_type ? static_cast<T*>(node) : nullptr;
+}
+
+// -----------------------------------------------------------------------------
+
 enum class SceneIterateDirection
 {
     front_to_back,
@@ -175,8 +270,8 @@ static constexpr auto scene_iterate_default = [](auto*) {};
 template<typename Visit>
 auto scene_visit(SceneNode* node, Visit&& visit)
 {
-    if (auto* tree = dynamic_cast<SceneTree*>(node)) {
-        return visit(tree);
+    if (node->type == SceneNodeType::tree) {
+        return visit(static_cast<SceneTree*>(node));
     } else {
         return visit(node);
     }
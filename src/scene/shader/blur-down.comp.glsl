@@ -0,0 +1,29 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "blur.h"
+
+layout(push_constant, scalar) uniform PushConstants { SceneBlurInput bi; };
+
+layout(local_size_x = SCENE_BLUR_GROUP_SIZE, local_size_y = SCENE_BLUR_GROUP_SIZE) in;
+
+// Dual Kawase downsample: averages the 2x2 source block under each pixel, and the four blocks around its corners
+
+void main()
+{
+    vec2i32 local = vec2i32(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(local, bi.extent))) return;
+
+    vec2i32 pixel = bi.offset + local;
+
+    vec2f32 texel = 1.0 / vec2f32(image_dimensions(bi.src));
+    vec2f32 uv = (vec2f32(pixel) + 0.5) / vec2f32(image_dimensions(bi.dst));
+
+    vec4f32 sum = image_sample_lod(bi.src, uv, 0) * 4.0;
+    sum += image_sample_lod(bi.src, uv + vec2f32(-texel.x, -texel.y), 0);
+    sum += image_sample_lod(bi.src, uv + vec2f32( texel.x, -texel.y), 0);
+    sum += image_sample_lod(bi.src, uv + vec2f32(-texel.x,  texel.y), 0);
+    sum += image_sample_lod(bi.src, uv + vec2f32( texel.x,  texel.y), 0);
+
+    image_store(bi.dst, pixel, sum / 8.0);
+}
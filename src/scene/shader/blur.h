@@ -0,0 +1,16 @@
+#ifndef SCENE_BLUR_H
+#define SCENE_BLUR_H
+
+#include "gpu/shaders/shared.h"
+
+#define SCENE_BLUR_GROUP_SIZE 16
+
+struct SceneBlurInput
+{
+    GpuImageHandle src;
+    GpuImageHandle dst;
+    vec2i32 offset; // First destination pixel covered by the dispatch
+    vec2i32 extent; // Destination pixels covered by the dispatch
+};
+
+#endif // SCENE_BLUR_H
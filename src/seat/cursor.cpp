@@ -3,11 +3,18 @@
 #include <core/math.hpp>
 #include <core/log.hpp>
 
+// Holds a full theme at common cursor sizes
+static constexpr u32 seat_cursor_atlas_size = 512;
+
 struct SeatCursorManager
 {
     Gpu* gpu;
     Ref<GpuSampler> sampler;
 
+    // Cursor images share atlas pages, holding one descriptor between them
+    Ref<GpuAtlas> atlas;
+    RefVector<GpuAtlasEntry> atlas_entries;
+
     std::string theme;
     i32         size;
 
@@ -27,6 +34,11 @@ auto seat_cursor_manager_create(Gpu* gpu, const char* theme, i32 size) -> Ref<Se
         .min = VK_FILTER_LINEAR,
     });
 
+    cursor_manager->atlas = gpu_atlas_create(gpu, {
+        .extent = {seat_cursor_atlas_size, seat_cursor_atlas_size},
+        .format = gpu_format_from_drm(DRM_FORMAT_ABGR8888),
+    });
+
     return cursor_manager;
 }
 
@@ -54,6 +66,11 @@ void set_visual(SeatPointer* pointer, SceneNode* visual)
     }
 }
 
+auto seat_pointer_get_cursor_tree(SeatPointer* pointer) -> SceneTree*
+{
+    return pointer->tree.get();
+}
+
 void seat_pointer_set_cursor(SeatPointer* pointer, SceneNode* visual)
 {
     if (visual != get_visual(pointer)) {
@@ -83,15 +100,27 @@ auto get_xcursor(SeatCursorManager* manager, const char* semantic) -> SceneNode*
     }
 
     defer { XcursorImageDestroy(cursor); };
-    auto image = gpu_image_create(manager->gpu, {
-        .extent = {cursor->width, cursor->height},
-        .format = gpu_format_from_drm(DRM_FORMAT_ABGR8888),
-        .usage = GpuImageUsage::texture | GpuImageUsage::transfer
-    });
-    gpu_copy_memory_to_image(image.get(), as_bytes(cursor->pixels, cursor->width * cursor->height * 4), {{{image->extent()}}});
+    vec2u32 extent = {cursor->width, cursor->height};
+    auto pixels = as_bytes(cursor->pixels, cursor->width * cursor->height * 4);
 
     auto visual = scene_texture_create();
-    scene_texture_set_image(visual.get(), image.get(), manager->sampler.get(), GpuBlendMode::premultiplied);
+
+    // Cursors too large for an atlas page get an image of their own
+    if (auto entry = gpu_atlas_allocate(manager->atlas.get(), extent)) {
+        gpu_atlas_entry_upload(entry.get(), pixels);
+        scene_texture_set_image(visual.get(), entry->image, manager->sampler.get(), GpuBlendMode::premultiplied);
+        scene_texture_set_src(visual.get(), gpu_atlas_entry_get_uv(entry.get()));
+        manager->atlas_entries.emplace_back(std::move(entry));
+    } else {
+        auto image = gpu_image_create(manager->gpu, {
+            .extent = extent,
+            .format = gpu_format_from_drm(DRM_FORMAT_ABGR8888),
+            .usage = GpuImageUsage::texture | GpuImageUsage::transfer
+        });
+        gpu_copy_memory_to_image(image.get(), pixels, {{{extent}}});
+        scene_texture_set_image(visual.get(), image.get(), manager->sampler.get(), GpuBlendMode::premultiplied);
+    }
+
     scene_texture_set_dst(visual.get(), {-vec2f32{f32(cursor->xhot), f32(cursor->yhot)}, {f32(cursor->width), f32(cursor->height)}, xywh});
 
     manager->cache.insert({semantic, visual});
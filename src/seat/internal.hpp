@@ -79,6 +79,8 @@ struct SeatPointer : SeatInputDevice
     SceneTree* root;
 
     Ref<SceneTree> tree;
+
+    SeatPointerSignals signals;
 };
 
 // -----------------------------------------------------------------------------
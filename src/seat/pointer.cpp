@@ -96,12 +96,17 @@ void seat_pointer_button(SeatPointer* pointer, SeatInputCode code, bool pressed,
 
 void seat_pointer_move(SeatPointer* pointer, vec2f32 position, vec2f32 rel_accel, vec2f32 rel_unaccel)
 {
-    bool send_event = pointer->tree->translation != position
+    bool moved = pointer->tree->translation != position;
+    bool send_event = moved
                    || rel_accel.x   || rel_accel.y
                    || rel_unaccel.x || rel_unaccel.y;
 
     scene_tree_set_translation(pointer->tree.get(), position);
 
+    if (moved) {
+        pointer->signals.moved();
+    }
+
     update_pointer_focus(pointer);
 
     if (!send_event) return;
@@ -152,3 +157,8 @@ auto seat_pointer_get_seat(SeatPointer* pointer) -> Seat*
 {
     return pointer->seat;
 }
+
+auto seat_pointer_get_signals(SeatPointer* pointer) -> SeatPointerSignals&
+{
+    return pointer->signals;
+}
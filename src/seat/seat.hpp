@@ -2,6 +2,8 @@
 
 #include <scene/scene.hpp>
 
+#include <core/signal.hpp>
+
 struct SeatFocus;
 
 // -----------------------------------------------------------------------------
@@ -82,6 +84,16 @@ void seat_pointer_move(  SeatPointer*, vec2f32 position, vec2f32 rel_accel, vec2
 void seat_pointer_set_cursor( SeatPointer*, SceneNode*);
 void seat_pointer_set_xcursor(SeatPointer*, const char* xcursor_semantic);
 
+// Tree holding the current cursor visual, translated to the pointer position
+auto seat_pointer_get_cursor_tree(SeatPointer*) -> SceneTree*;
+
+struct SeatPointerSignals
+{
+    Signal<void()> moved;
+};
+
+auto seat_pointer_get_signals(SeatPointer*) -> SeatPointerSignals&;
+
 struct SeatKeyboardInfo
 {
     xkb_context* context;
@@ -0,0 +1,175 @@
+#include "../shell.hpp"
+
+#include <ui/ui.hpp>
+
+#include <core/math.hpp>
+#include <core/memory.hpp>
+
+// Timings resolve after their submission completes, so the overlay refreshes on a timer instead of
+// requesting a frame for each new timing (which would itself produce new timings)
+static constexpr auto shell_gpu_timings_refresh = 250ms;
+
+struct ShellGpuTimings
+{
+    Shell* shell;
+
+    Listener<void()> frame;
+    Ref<ExecTimer> refresh;
+};
+
+static
+void frame(ShellGpuTimings*);
+
+void shell_init_gpu_timings(Shell* shell)
+{
+    auto timings = ref_create<ShellGpuTimings>();
+    timings->shell = shell;
+
+    timings->refresh = exec_timer_create(shell->exec, [shell] {
+        ui_request_frame(shell->ui.get());
+    });
+
+    timings->frame = ui_get_signals(shell->ui.get()).frame.listen([timings = timings.get()] {
+        frame(timings);
+    });
+
+    shell->apps.emplace_back(timings);
+}
+
+static
+auto to_ms(std::chrono::nanoseconds duration) -> f32
+{
+    return std::chrono::duration<f32, std::milli>(duration).count();
+}
+
+// Timings are recorded in submission order, but only for submissions that contain timed passes
+static
+auto find_gpu_time(Gpu* gpu, u64 submission) -> std::chrono::nanoseconds
+{
+    for (u32 age = 0; age < gpu_timings_max; ++age) {
+        auto* timing = gpu_get_timing(gpu, age);
+        if (!timing || timing->submission < submission) break;
+        if (timing->submission == submission) return timing->total;
+    }
+    return {};
+}
+
+static
+void show_timings(Gpu* gpu)
+{
+    if (!gpu->timings.period) {
+        ImGui::TextUnformatted("Timestamps are not supported on the graphics queue");
+        return;
+    }
+
+    auto* latest = gpu_get_timing(gpu, 0);
+    if (!latest) {
+        ImGui::TextUnformatted("No submissions timed yet");
+        return;
+    }
+
+    // Submission totals, oldest first
+
+    std::array<f32, gpu_timings_max> totals;
+    u32 count = 0;
+    f32 sum = 0.f;
+    f32 max = 0.f;
+    for (u32 age = gpu_timings_max; age-- > 0;) {
+        auto* timing = gpu_get_timing(gpu, age);
+        if (!timing) continue;
+
+        auto ms = to_ms(timing->total);
+        totals[count++] = ms;
+        sum += ms;
+        max = std::max(max, ms);
+    }
+
+    ui_text("Submission {}: {:.3f} ms", latest->submission, to_ms(latest->total));
+    ui_text("Average {:.3f} ms, max {:.3f} ms over {} submissions", sum / count, max, count);
+
+    ImGui::PlotLines("##totals", totals.data(), count, 0, nullptr, 0.f, max, ImVec2(-1, 80));
+
+    ImGui::Separator();
+
+    if (!ImGui::BeginTable("passes", 2)) return;
+
+    auto row = [&](const char* name, std::string value) {
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(name);
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(value.c_str());
+    };
+
+    row("Render",  std::format("{:.3f} ms", to_ms(latest->passes[std::to_underlying(GpuPassType::render)])));
+    row("Compute", std::format("{:.3f} ms", to_ms(latest->passes[std::to_underlying(GpuPassType::compute)])));
+    row("Copy",    std::format("{:.3f} ms", to_ms(latest->passes[std::to_underlying(GpuPassType::copy)])));
+    row("Passes",  latest->untimed
+        ? std::format("{} ({} untimed)", latest->timed, latest->untimed)
+        : std::format("{}", latest->timed));
+
+    ImGui::EndTable();
+}
+
+// Per output frame counters, recorded by the io bridge
+static
+void show_frame_stats(Gpu* gpu, ShellOutputStats* stats)
+{
+    if (!stats->count) {
+        ImGui::TextUnformatted("No frames recorded yet");
+        return;
+    }
+
+    auto& latest = stats->history[(stats->count - 1) % shell_frame_stats_max];
+
+    ui_text("Frame {}{}", stats->count, latest.scanout ? " (direct scanout)" : "");
+    ui_text("Images {}, buffers {}, allocations {}",
+        FmtBytes(latest.image_memory), FmtBytes(latest.buffer_memory), latest.allocations);
+
+    // Plots each counter over the recorded frames, oldest first
+
+    auto first = stats->count - std::min<u64>(stats->count, shell_frame_stats_max);
+
+    auto plot = [&](const char* label, auto&& get_value, const char* unit) {
+        std::array<f32, shell_frame_stats_max> values;
+        u32 count = 0;
+        f32 max = 0.f;
+        for (u64 i = first; i < stats->count; ++i) {
+            f32 value = get_value(stats->history[i % shell_frame_stats_max]);
+            values[count++] = value;
+            max = std::max(max, value);
+        }
+
+        auto overlay = std::format("{:.2f}{} (max {:.2f})", values[count - 1], unit, max);
+        ImGui::PlotLines(label, values.data(), count, 0, overlay.c_str(), 0.f, max, ImVec2(0, 40));
+    };
+
+    plot("CPU",        [&](auto& f) { return to_ms(f.cpu); },                              " ms");
+    plot("GPU",        [&](auto& f) { return to_ms(find_gpu_time(gpu, f.submission)); },   " ms");
+    plot("Flip",       [&](auto& f) { return to_ms(f.interval); },                         " ms");
+    plot("Draws",      [&](auto& f) { return f32(f.render.draws); },                       "");
+    plot("Vertices",   [&](auto& f) { return f32(f.render.vertices); },                    "");
+    plot("Dispatches", [&](auto& f) { return f32(f.render.dispatches); },                  "");
+    plot("Uploaded",   [&](auto& f) { return f32(f.uploaded_bytes) / 1024.f; },            " KiB");
+    plot("Events",     [&](auto& f) { return f32(f.events_handled); },                     "");
+    plot("Poll waits", [&](auto& f) { return f32(f.poll_waits); },                         "");
+}
+
+static
+void frame(ShellGpuTimings* timings)
+{
+    auto* shell = timings->shell;
+    auto* gpu = shell->gpu.get();
+
+    defer { ImGui::End(); };
+    if (!ImGui::Begin("GPU Timings")) return;
+
+    exec_timer_set(timings->refresh.get(), std::chrono::steady_clock::now() + shell_gpu_timings_refresh);
+
+    show_timings(gpu);
+
+    for (auto* stats : shell->output_stats) {
+        ImGui::PushID(stats);
+        if (ImGui::CollapsingHeader(std::format("Output {}", stats->id).c_str())) {
+            show_frame_stats(gpu, stats);
+        }
+        ImGui::PopID();
+    }
+}
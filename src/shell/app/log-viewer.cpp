@@ -78,6 +78,12 @@ void frame(ShellLogViewer* viewer)
     ImGui::SameLine();
     ImGui::Checkbox("Details", &viewer->show_details);
 
+    // GPU cost of the most recent submission, to correlate with nearby log entries
+    if (auto* timing = gpu_get_timing(viewer->shell->gpu.get(), 0)) {
+        ImGui::SameLine();
+        ui_text("GPU: {:.3f} ms", std::chrono::duration<f32, std::milli>(timing->total).count());
+    }
+
     static constexpr auto make_color = [](std::string_view hex) {
         auto v = vec_cast<f32>(color_from_hex(hex)) / 255.f;
         return ImVec4(v.x, v.y, v.z, v.w);
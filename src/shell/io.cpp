@@ -1,5 +1,7 @@
 #include "shell.hpp"
 
+#include <core/math.hpp>
+
 struct ShellInputDevice
 {
     IoInputDevice* io;
@@ -10,31 +12,333 @@ struct ShellOutput
 {
     IoOutput* io;
     Ref<WmOutput> wm;
+
+    // Images are pooled per output, so that buffer ages match the output's damage history
+    Ref<GpuImagePool>       pool;
+    Ref<SceneDamageTracker> damage;
+
+    Ref<GpuImagePool> cursor_pool;
+
+    // Scene bounds of textures presented on overlay planes in the last frame
+    std::vector<aabb2f32> overlays;
+
+    ShellVrrPolicy vrr;
+
+    Ref<ShellOutputStats> stats;
+};
+
+// A node of the cursor, relative to the cursor tree so that moving the pointer doesn't change it
+struct ShellCursorPart
+{
+    SceneNode* node;
+    vec2f32    offset;
+    GpuImage*  image;
+    aabb2f32   src;
+    rect2f32   dst;
+
+    auto operator==(const ShellCursorPart&) const -> bool = default;
 };
 
 struct ShellIo
 {
+    Shell* shell;
     WmServer* wm;
     Gpu* gpu;
     IoContext* io;
 
-    Ref<GpuImagePool> pool;
+    ShellVrrPolicy vrr;
+    bool blur;
 
     std::vector<ShellInputDevice> input_devices;
     std::vector<ShellOutput> outputs;
+    u32 next_output_id;
+
+    // The cursor is shown on output cursor planes when every output can display it,
+    // in which case the seat's cursor tree is disabled and pointer motion needs no composition.
+    struct {
+        bool    hardware;
+        bool    dirty;
+        vec2i32 offset; // Cursor image origin relative to the pointer position
+
+        // Appearance last rejected by the cursor planes, which isn't retried until it changes
+        std::optional<std::vector<ShellCursorPart>> rejected;
+    } cursor;
 
     Listener<void(IoEvent*)> listener;
+    Listener<void()> pointer_moved;
 };
 
 static
-auto find_output(ShellIo* shell_io, IoOutput* io_output) -> WmOutput*
+auto find_output(ShellIo* shell_io, IoOutput* io_output) -> ShellOutput*
 {
     for (auto& o : shell_io->outputs) {
-        if (o.io == io_output) return o.wm.get();
+        if (o.io == io_output) return &o;
     }
     return nullptr;
 };
 
+static
+auto get_cursor_tree(ShellIo* shell_io) -> SceneTree*
+{
+    return seat_pointer_get_cursor_tree(seat_get_pointer(wm_get_seat(shell_io->wm)));
+}
+
+static
+auto is_cursor_node(ShellIo* shell_io, SceneNode* node) -> bool
+{
+    auto* cursor_tree = get_cursor_tree(shell_io);
+    for (auto* tree = scene_node_cast<SceneTree>(node) ?: node->parent; tree; tree = tree->parent) {
+        if (tree == cursor_tree) return true;
+    }
+    return false;
+}
+
+static
+auto get_cursor_parts(SceneTree* cursor_tree) -> std::vector<ShellCursorPart>
+{
+    std::vector<ShellCursorPart> parts;
+    scene_iterate<SceneIterateDirection::back_to_front>(cursor_tree,
+        [&](SceneTree* tree) {
+            // The cursor tree itself is disabled while the cursor is on cursor planes
+            return tree == cursor_tree || tree->enabled
+                ? SceneIterateAction::next
+                : SceneIterateAction::skip;
+        },
+        [&](SceneNode* node) {
+            ShellCursorPart part { .node = node };
+
+            // Summed from translations, as world positions round differently as the pointer moves
+            for (auto* tree = node->parent; tree != cursor_tree; tree = tree->parent) {
+                part.offset += tree->translation;
+            }
+            if (auto* texture = scene_node_cast<SceneTexture>(node)) {
+                part.image = texture->image.get();
+                part.src = texture->src;
+                part.dst = texture->dst;
+            }
+            parts.emplace_back(part);
+        },
+        scene_iterate_default);
+    return parts;
+}
+
+static
+void move_cursors(ShellIo* shell_io)
+{
+    if (!shell_io->cursor.hardware) return;
+
+    auto position = vec_floor(scene_tree_get_position(get_cursor_tree(shell_io)));
+    for (auto& output : shell_io->outputs) {
+        auto origin = wm_output_get_viewport(output.wm.get()).origin;
+        output.io->move_cursor(vec_cast<i32>(position - origin) + shell_io->cursor.offset);
+    }
+}
+
+static
+auto render_cursor(ShellIo* shell_io, ShellOutput* output, SceneTree* tree, aabb2i32 bounds) -> Ref<GpuImage>
+{
+    auto cursor = output->io->info().cursor;
+    if (bounds.max.x - bounds.min.x > i32(cursor.size.x)) return nullptr;
+    if (bounds.max.y - bounds.min.y > i32(cursor.size.y)) return nullptr;
+
+    // Cursor planes commonly only support a few linear formats
+    auto usage = GpuImageUsage::render;
+    for (auto drm_format : {DRM_FORMAT_ARGB8888, DRM_FORMAT_ABGR8888}) {
+        auto format = gpu_format_from_drm(drm_format);
+        auto modifiers = gpu_intersect_format_modifiers({{
+            &gpu_get_format_properties(shell_io->gpu, format, usage)->mods,
+            &cursor.formats->get(format),
+        }});
+        if (modifiers.empty()) continue;
+
+        auto image = output->cursor_pool->acquire({
+            .extent = cursor.size,
+            .format = format,
+            .usage = usage,
+            .modifiers = &modifiers,
+        }, nullptr);
+
+        auto position = vec_floor(scene_tree_get_position(tree));
+        scene_render_tree(tree, image.get(), {position + vec_cast<f32>(bounds.min), vec_cast<f32>(cursor.size), xywh});
+
+        return image;
+    }
+
+    return nullptr;
+}
+
+static
+void update_cursor(ShellIo* shell_io)
+{
+    auto* tree = get_cursor_tree(shell_io);
+
+    auto parts = get_cursor_parts(tree);
+    if (shell_io->cursor.rejected == parts) {
+        shell_io->cursor.dirty = false;
+        return;
+    }
+
+    auto bounds = scene_tree_get_bounds(tree);
+    bool empty = bounds.max.x <= bounds.min.x || bounds.max.y <= bounds.min.y;
+
+    aabb2i32 pixels = {vec_cast<i32>(vec_floor(bounds.min)), vec_cast<i32>(vec_ceil(bounds.max)), minmax};
+
+    bool hardware = !shell_io->outputs.empty();
+    for (auto& output : shell_io->outputs) {
+        if (empty) {
+            output.io->set_cursor(nullptr, {});
+            continue;
+        }
+
+        auto image = render_cursor(shell_io, &output, tree, pixels);
+        if (!image || !output.io->set_cursor(image.get(), gpu_flush(shell_io->gpu))) {
+            hardware = false;
+            break;
+        }
+    }
+
+    if (!hardware) {
+        for (auto& output : shell_io->outputs) {
+            output.io->set_cursor(nullptr, {});
+        }
+    }
+
+    shell_io->cursor.hardware = hardware;
+    shell_io->cursor.offset = pixels.min;
+    shell_io->cursor.rejected = hardware ? std::nullopt : std::optional(std::move(parts));
+    scene_tree_set_enabled(tree, !hardware);
+
+    // Cleared last, as toggling the tree damages the cursor
+    shell_io->cursor.dirty = false;
+
+    move_cursors(shell_io);
+}
+
+static
+auto get_commit_flags(ShellOutput* output) -> Flags<IoOutputCommitFlag>
+{
+    Flags<IoOutputCommitFlag> flags = IoOutputCommitFlag::vsync;
+
+    // Variable refresh on the desktop makes the panel flicker as the rate swings between
+    // idle and animation, so by default it's limited to a focused fullscreen client.
+    bool vrr = [&] {
+        switch (output->vrr) {
+            break;case ShellVrrPolicy::off:
+                return false;
+            break;case ShellVrrPolicy::always:
+                return true;
+            break;case ShellVrrPolicy::fullscreen: {
+                auto* window = wm_output_get_fullscreen_window(output->wm.get());
+                return window && wm_window_is_focused(window);
+            }
+        }
+        return false;
+    }();
+    if (vrr) flags |= IoOutputCommitFlag::vrr;
+
+    return flags;
+}
+
+static
+auto try_scanout(ShellIo* shell_io, ShellOutput* output) -> bool
+{
+    if (!wm_output_get_fullscreen_window(output->wm.get())) return false;
+
+    auto* texture = scene_find_scanout(wm_get_scene(shell_io->wm), wm_output_get_viewport(output->wm.get()));
+    if (!texture) return false;
+
+    // Only client dmabufs with an explicit modifier can be handed to the output
+    auto* image = texture->image.get();
+    if (image->modifier() == DRM_FORMAT_MOD_INVALID) return false;
+    if (!output->io->info().formats->get(image->format()).contains(image->modifier())) return false;
+
+    // Damage keeps accumulating in the tracker while scanning out, so composition
+    // resumes with the correct damage for whichever pool image is acquired next.
+    return output->io->commit(image, gpu_flush(shell_io->gpu), get_commit_flags(output) | IoOutputCommitFlag::scanout);
+}
+
+static
+auto find_overlays(ShellIo* shell_io, ShellOutput* output, std::vector<SceneTexture*>* textures) -> std::vector<IoOutputLayer>
+{
+    auto info = output->io->info();
+    auto viewport = wm_output_get_viewport(output->wm.get());
+
+    *textures = scene_find_overlays(wm_get_scene(shell_io->wm), viewport, info.overlays.formats, info.overlays.count);
+
+    std::vector<IoOutputLayer> layers;
+    for (auto* texture : *textures) {
+        auto position = scene_tree_get_position(texture->parent) + texture->dst.origin - viewport.origin;
+        layers.emplace_back(texture->image.get(), rect2i32{vec_cast<i32>(vec_round(position)), vec_cast<i32>(vec_round(texture->dst.extent)), xywh});
+    }
+
+    // Promoted textures never overlap each other or anything above them,
+    // so layers can be dropped in any order until the output accepts them.
+    while (!layers.empty() && !output->io->test_layers(layers)) {
+        layers.pop_back();
+        textures->pop_back();
+    }
+
+    // Areas that move between overlays and the composited image must be repainted
+    std::vector<aabb2f32> bounds;
+    for (auto& layer : layers) {
+        bounds.emplace_back(vec_cast<f32>(layer.dst.origin) + viewport.origin, vec_cast<f32>(layer.dst.extent), xywh);
+    }
+    if (bounds != output->overlays) {
+        for (auto& aabb : output->overlays) scene_damage_tracker_damage(output->damage.get(), aabb);
+        for (auto& aabb : bounds)           scene_damage_tracker_damage(output->damage.get(), aabb);
+        output->overlays = std::move(bounds);
+    }
+
+    return layers;
+}
+
+static
+auto create_output_stats(ShellIo* shell_io) -> Ref<ShellOutputStats>
+{
+    auto* exec = shell_io->shell->exec;
+
+    auto stats = ref_create<ShellOutputStats>();
+    stats->id = ++shell_io->next_output_id;
+    stats->totals = {
+        .uploaded_bytes = shell_io->gpu->stats.uploaded_bytes,
+        .events_handled = exec->stats.events_handled,
+        .poll_waits     = exec->stats.poll_waits,
+    };
+    shell_io->shell->output_stats.emplace_back(stats.get());
+
+    return stats;
+}
+
+static
+void record_frame(ShellIo* shell_io, ShellOutput* output, std::chrono::steady_clock::time_point start, bool scanout)
+{
+    auto* gpu = shell_io->gpu;
+    auto* exec = shell_io->shell->exec;
+    auto& stats = *output->stats;
+
+    stats.history[stats.count++ % shell_frame_stats_max] = {
+        .time = start,
+        .cpu = std::chrono::steady_clock::now() - start,
+        .interval = output->io->flip_interval(),
+        // The frame was committed with the most recent flush
+        .submission = gpu->queue.submitted,
+        .scanout = scanout,
+        .render = scanout ? SceneRenderStats{} : scene_get_render_stats(wm_get_scene(shell_io->wm)),
+        .uploaded_bytes = gpu->stats.uploaded_bytes - stats.totals.uploaded_bytes,
+        .image_memory = gpu->stats.active_image_memory,
+        .buffer_memory = gpu->stats.active_buffer_memory,
+        .events_handled = exec->stats.events_handled - stats.totals.events_handled,
+        .poll_waits = exec->stats.poll_waits - stats.totals.poll_waits,
+        .allocations = registry_get_stats().active_allocations,
+    };
+
+    stats.totals = {
+        .uploaded_bytes = gpu->stats.uploaded_bytes,
+        .events_handled = exec->stats.events_handled,
+        .poll_waits     = exec->stats.poll_waits,
+    };
+}
+
 static
 void handle_event(ShellIo* shell_io, IoEvent* event)
 {
@@ -70,23 +374,40 @@ void handle_event(ShellIo* shell_io, IoEvent* event)
                 .request_frame = [](void* data) {
                     static_cast<IoOutput*>(data)->request_frame();
                 },
-            }));
+            }), gpu_image_pool_create(shell_io->gpu), scene_damage_tracker_create(wm_get_scene(shell_io->wm)),
+                gpu_image_pool_create(shell_io->gpu), std::vector<aabb2f32>{}, shell_io->vrr, create_output_stats(shell_io));
+            shell_io->cursor.rejected.reset();
+            shell_io->cursor.dirty = true;
         break;case IoEventType::output_configure:
-            wm_output_set_pixel_size(find_output(shell_io, event->output.output), event->output.output->info().size);
+            wm_output_set_pixel_size(find_output(shell_io, event->output.output)->wm.get(), event->output.output->info().size);
         break;case IoEventType::output_removed:
+            shell_io->shell->output_stats.erase(find_output(shell_io, event->output.output)->stats.get());
             std::erase_if(shell_io->outputs, [&](const auto& o) { return o.io == event->output.output; });
+            shell_io->cursor.rejected.reset();
+            shell_io->cursor.dirty = true;
         break;case IoEventType::output_frame: {
+            auto start = std::chrono::steady_clock::now();
+
             auto io_output = event->output.output;
             auto output = find_output(shell_io, io_output);
 
-            wm_output_frame(output);
+            wm_output_frame(output->wm.get());
 
-            // TODO: Only redraw with damage
+            if (shell_io->cursor.dirty) {
+                update_cursor(shell_io);
+            }
+
+            if (try_scanout(shell_io, output)) {
+                record_frame(shell_io, output, start, true);
+                break;
+            }
 
             auto format = gpu_format_from_drm(DRM_FORMAT_ABGR8888);
-            auto usage = GpuImageUsage::render;
+            Flags<GpuImageUsage> usage = GpuImageUsage::render;
+            if (shell_io->blur) usage |= GpuImageUsage::texture;
 
-            auto target = shell_io->pool->acquire({
+            u32 age;
+            auto target = output->pool->acquire({
                 .extent = io_output->info().size,
                 .format = format,
                 .usage = usage,
@@ -94,11 +415,17 @@ void handle_event(ShellIo* shell_io, IoEvent* event)
                     &gpu_get_format_properties(shell_io->gpu, format, usage)->mods,
                     &io_output->info().formats->get(format),
                 }}))
-            });
+            }, &age);
+
+            std::vector<SceneTexture*> overlays;
+            auto layers = find_overlays(shell_io, output, &overlays);
 
-            scene_render(wm_get_scene(shell_io->wm), target.get(), wm_output_get_viewport(output));
+            scene_render(wm_get_scene(shell_io->wm), target.get(), wm_output_get_viewport(output->wm.get()),
+                output->damage.get(), age, overlays);
 
-            io_output->commit(target.get(), gpu_flush(shell_io->gpu), IoOutputCommitFlag::vsync);
+            io_output->commit(target.get(), gpu_flush(shell_io->gpu), get_commit_flags(output), layers);
+
+            record_frame(shell_io, output, start, false);
         }
     }
 }
@@ -106,14 +433,36 @@ void handle_event(ShellIo* shell_io, IoEvent* event)
 void shell_init_io_bridge(Shell* shell)
 {
     auto shell_io = ref_create<ShellIo>();
+    shell_io->shell = shell;
     shell_io->wm = shell->wm.get();
     shell_io->gpu = shell->gpu.get();
     shell_io->io = shell->io.get();
-    shell_io->pool = gpu_image_pool_create(shell_io->gpu);
+    shell_io->vrr = shell->vrr;
+    shell_io->blur = shell->blur;
     shell_io->listener = io_get_signals(shell->io.get()).event
         .listen([shell_io = shell_io.get()](IoEvent* event) {
             handle_event(shell_io, event);
         });
 
+    shell_io->pointer_moved = seat_pointer_get_signals(seat_get_pointer(wm_get_seat(shell_io->wm))).moved
+        .listen([shell_io = shell_io.get()] {
+            move_cursors(shell_io);
+        });
+
+    // Cursor damage doesn't request frames while the cursor tree is disabled,
+    // so changes to the cursor's contents are picked up here instead.
+    scene_add_damage_listener(wm_get_scene(shell_io->wm), [shell_io = Weak(shell_io.get())](SceneNode* node) {
+        if (!shell_io || !is_cursor_node(shell_io.get(), node)) return;
+
+        // A rejected cursor is composited, and moving it damages it without changing how it looks
+        auto& rejected = shell_io->cursor.rejected;
+        if (rejected && *rejected == get_cursor_parts(get_cursor_tree(shell_io.get()))) return;
+
+        shell_io->cursor.dirty = true;
+        for (auto& output : shell_io->outputs) {
+            output.io->request_frame();
+        }
+    });
+
     shell->apps.emplace_back(shell_io);
 }
@@ -29,6 +29,15 @@ auto main(int argc, char* argv[]) -> int
 
     shell->app_share = std::filesystem::path(getenv("HOME")) / ".local/share" / PROGRAM_NAME;
     shell->wallpaper = getenv("WALLPAPER") ?: "";
+    if (std::string_view vrr = getenv("VRR") ?: ""; !vrr.empty()) {
+        if      (vrr == "off")        shell->vrr = ShellVrrPolicy::off;
+        else if (vrr == "always")     shell->vrr = ShellVrrPolicy::always;
+        else if (vrr == "fullscreen") shell->vrr = ShellVrrPolicy::fullscreen;
+        else log_warn("Unknown VRR policy: {}", vrr);
+    }
+    if (std::string_view blur = getenv("BLUR") ?: ""; !blur.empty()) {
+        shell->blur = blur != "0";
+    }
     if (getenv("WAYLAND_DISPLAY")) {
         log_debug("Running nested!");
         shell->main_mod = SeatModifier::alt;
@@ -54,6 +63,7 @@ auto main(int argc, char* argv[]) -> int
     shell_init_background(shell.get());
     shell_init_launcher(shell.get());
     shell_init_log_viewer(shell.get());
+    shell_init_gpu_timings(shell.get());
     shell_init_menu(shell.get());
     shell_init_xwayland(shell.get(), argc, argv);
 
@@ -5,6 +5,61 @@
 #include <io/io.hpp>
 #include <ui/ui.hpp>
 
+enum class ShellVrrPolicy
+{
+    off,
+    always,
+    fullscreen, // Only while a focused window is fullscreen on the output
+};
+
+// -----------------------------------------------------------------------------
+
+/**
+ * Counters for a single output frame. Cumulative counters are recorded as the
+ * change since the output's previous frame.
+ */
+struct ShellFrameStats
+{
+    std::chrono::steady_clock::time_point time;
+
+    std::chrono::nanoseconds cpu;      // From the frame event until the commit
+    std::chrono::nanoseconds interval; // Between the two most recent page flips before the frame
+
+    u64  submission; // Graphics submission containing the frame, see `gpu_get_timing`
+    bool scanout;    // Presented without composition
+
+    SceneRenderStats render;
+    u64 uploaded_bytes;
+
+    usz image_memory;
+    usz buffer_memory;
+
+    u64 events_handled;
+    u64 poll_waits;
+
+    u32 allocations; // Active registry allocations
+};
+
+static constexpr u32 shell_frame_stats_max = 256;
+
+struct ShellOutputStats
+{
+    u32 id;
+
+    // The most recent frames, indexed by `count % shell_frame_stats_max`
+    std::array<ShellFrameStats, shell_frame_stats_max> history;
+    u64 count;
+
+    // Cumulative counters as of the last recorded frame
+    struct {
+        u64 uploaded_bytes;
+        u64 events_handled;
+        u64 poll_waits;
+    } totals;
+};
+
+// -----------------------------------------------------------------------------
+
 struct Shell
 {
     ExecContext* exec;
@@ -19,8 +74,17 @@ struct Shell
     std::filesystem::path app_share;
     std::filesystem::path wallpaper;
 
+    // Default variable refresh policy for new outputs
+    ShellVrrPolicy vrr = ShellVrrPolicy::fullscreen;
+
+    // Renders outputs to sampleable images, so that windows can blur what's behind them
+    bool blur;
+
     std::string xwayland_socket;
 
+    // Frame statistics for each output, recorded by the io bridge
+    RefVector<ShellOutputStats> output_stats;
+
     RefVector<void> apps;
 
     ~Shell()
@@ -38,5 +102,6 @@ void shell_init_xwayland(Shell*, int argc, char* argv[]);
 void shell_init_menu(Shell*);
 void shell_init_launcher(Shell*);
 void shell_init_log_viewer(Shell*);
+void shell_init_gpu_timings(Shell*);
 void shell_init_background(Shell*);
 void shell_init_io_bridge(Shell*);
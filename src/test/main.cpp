@@ -0,0 +1,18 @@
+#include "test.hpp"
+
+#include <core/object.hpp>
+
+auto main() -> int
+{
+    log_init("tests.log");
+    registry_init();
+    defer {
+        registry_deinit();
+        log_deinit();
+    };
+
+    test_region();
+
+    if (test_failures) log_error("{} checks failed", test_failures);
+    return test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,318 @@
+#include "test.hpp"
+
+#include <core/region.hpp>
+
+// Pixels covered by the reference raster, sized so random boxes also fall partly outside it
+static constexpr i32 test_region_grid = 32;
+
+// -----------------------------------------------------------------------------
+
+template<typename T>
+static
+auto is_canonical(const Region<T>& region) -> bool
+{
+    auto& aabbs = region.aabbs;
+    usz band = 0;
+    for (usz i = 0; i < aabbs.size(); ++i) {
+        auto& aabb = aabbs[i];
+        if (!(aabb.max.x > aabb.min.x && aabb.max.y > aabb.min.y)) return false;
+        if (i == band) continue;
+
+        auto& last = aabbs[i - 1];
+        if (aabb.min.y == last.min.y) {
+            // Same band, spans must be sorted and not touch
+            if (aabb.max.y != last.max.y || aabb.min.x <= last.max.x) return false;
+            continue;
+        }
+
+        // New band, below the previous one
+        if (aabb.min.y < last.max.y) return false;
+
+        // Touching bands must differ, or they would have been merged
+        if (aabb.min.y == last.max.y) {
+            auto upper = std::span(aabbs).subspan(band, i - band);
+            auto lower = std::span(aabbs).subspan(i);
+            usz count = 0;
+            while (count < lower.size() && lower[count].min.y == aabb.min.y) count++;
+            if (count == upper.size() && std::ranges::equal(upper, lower.first(count), {},
+                    [](auto& a) { return std::pair(a.min.x, a.max.x); },
+                    [](auto& a) { return std::pair(a.min.x, a.max.x); })) {
+                return false;
+            }
+        }
+
+        band = i;
+    }
+    return true;
+}
+
+// Reference raster of a region, compared pixel by pixel
+struct TestRaster
+{
+    std::array<std::array<bool, test_region_grid>, test_region_grid> pixels = {};
+
+    void apply(aabb2i32 aabb, auto&& op)
+    {
+        for (i32 y = 0; y < test_region_grid; ++y) {
+            for (i32 x = 0; x < test_region_grid; ++x) {
+                pixels[y][x] = op(pixels[y][x], aabb_contains(aabb, {x, y}));
+            }
+        }
+    }
+
+    auto matches(const region2i32& region) const -> bool
+    {
+        for (i32 y = 0; y < test_region_grid; ++y) {
+            for (i32 x = 0; x < test_region_grid; ++x) {
+                if (region.contains(vec2i32{x, y}) != pixels[y][x]) return false;
+            }
+        }
+        return true;
+    }
+};
+
+static
+void test_canonical_form()
+{
+    std::minstd_rand rng(1);
+    std::uniform_int_distribution<i32> pos(-4, test_region_grid);
+    std::uniform_int_distribution<i32> size(0, 12);
+    std::uniform_int_distribution<u32> op(0, 2);
+
+    for (u32 round = 0; round < 64; ++round) {
+        region2i32 region;
+        TestRaster raster;
+
+        for (u32 step = 0; step < 32; ++step) {
+            aabb2i32 aabb = {{pos(rng), pos(rng)}, {size(rng), size(rng)}, xywh};
+            switch (op(rng)) {
+                break;case 0:
+                    region.add(aabb);
+                    raster.apply(aabb, [](bool a, bool b) { return a || b; });
+                break;case 1:
+                    region.subtract(aabb);
+                    raster.apply(aabb, [](bool a, bool b) { return a && !b; });
+                break;case 2:
+                    // Intersections quickly empty the region, so they're done against a large box
+                    aabb = {aabb.min - 8, aabb.max + 16, minmax};
+                    region.intersect(aabb);
+                    raster.apply(aabb, [](bool a, bool b) { return a && b; });
+            }
+
+            test_check(is_canonical(region));
+            test_check(raster.matches(region));
+        }
+    }
+
+    // Equal pixel sets built in different orders compare equal
+
+    region2i32 a, b;
+    a.add(aabb2i32{{0, 0}, {10, 10}, xywh});
+    a.add(aabb2i32{{5, 5}, {10, 10}, xywh});
+    b.add(aabb2i32{{5, 5}, {10, 10}, xywh});
+    b.add(aabb2i32{{0, 0}, {10, 10}, xywh});
+    test_check(a == b);
+}
+
+static
+void test_coalescing()
+{
+    // Vertically adjacent bands with identical spans merge
+
+    region2i32 region;
+    region.add(aabb2i32{{0,  0}, {10, 10}, xywh});
+    region.add(aabb2i32{{0, 10}, {10, 10}, xywh});
+    test_check(region.aabbs.size() == 1);
+    test_check(region.aabbs.front() == aabb2i32({0, 0}, {10, 20}, minmax));
+
+    // With multiple spans
+
+    region.clear();
+    region.add(aabb2i32{{ 0, 0}, {10, 10}, xywh});
+    region.add(aabb2i32{{20, 0}, {10, 10}, xywh});
+    region.add(aabb2i32{{ 0, 10}, {10, 10}, xywh});
+    region.add(aabb2i32{{20, 10}, {10, 10}, xywh});
+    test_check(region.aabbs.size() == 2);
+    test_check(region.aabbs[0] == aabb2i32({ 0, 0}, {10, 20}, minmax));
+    test_check(region.aabbs[1] == aabb2i32({20, 0}, {30, 20}, minmax));
+
+    // Touching spans within a band merge
+
+    region.clear();
+    region.add(aabb2i32{{ 0, 0}, {10, 10}, xywh});
+    region.add(aabb2i32{{10, 0}, {10, 10}, xywh});
+    test_check(region.aabbs.size() == 1);
+
+    // Punching a hole splits bands, and filling it back in restores a single box
+
+    region.subtract(aabb2i32{{5, 5}, {2, 2}, xywh});
+    test_check(region.aabbs.size() == 4);
+    test_check(is_canonical(region));
+    region.add(aabb2i32{{5, 5}, {2, 2}, xywh});
+    test_check(region.aabbs.size() == 1);
+    test_check(region.aabbs.front() == aabb2i32({0, 0}, {20, 10}, minmax));
+
+    // Bands that don't touch stay apart
+
+    region.clear();
+    region.add(aabb2i32{{0,  0}, {10, 10}, xywh});
+    region.add(aabb2i32{{0, 11}, {10, 10}, xywh});
+    test_check(region.aabbs.size() == 2);
+}
+
+static
+void test_empty()
+{
+    aabb2i32 box = {{0, 0}, {10, 10}, xywh};
+
+    test_check(region2i32(aabb2i32{{5, 5}, {0, 10}, xywh}).empty());
+    test_check(region2i32(aabb2i32{{5, 5}, {10, -1}, xywh}).empty());
+
+    region2i32 region = box;
+    region.add(aabb2i32{{20, 20}, {0, 0}, xywh});
+    test_check(region == region2i32(box));
+
+    region.subtract(box);
+    test_check(region.empty());
+
+    region = box;
+    region.subtract(aabb2i32{{-5, -5}, {20, 20}, xywh});
+    test_check(region.empty());
+
+    region = box;
+    region.intersect(aabb2i32{{10, 0}, {10, 10}, xywh});
+    test_check(region.empty());
+
+    region = box;
+    region.intersect(region2i32{});
+    test_check(region.empty());
+
+    region.clear();
+    region.intersect(box);
+    test_check(region.empty());
+    region.subtract(box);
+    test_check(region.empty());
+    test_check(!region.contains(vec2i32{0, 0}));
+    test_check(region.bounds() == aabb2i32{});
+}
+
+static
+void test_contains_edges()
+{
+    // Both the scanning and the searching paths, and a mix of point types
+
+    auto check = [](const region2f32& region, bool large) {
+        test_check((region.aabbs.size() > region_scan_max) == large);
+
+        // First band: spans [0, 10) and [20, 30) in [0, 10)
+        test_check( region.contains(vec2f32{0.f, 0.f}));
+        test_check( region.contains(vec2f32{9.5f, 9.5f}));
+        test_check(!region.contains(vec2f32{10.f, 5.f}));
+        test_check( region.contains(vec2f32{20.f, 5.f}));
+        test_check(!region.contains(vec2f32{30.f, 5.f}));
+        test_check(!region.contains(vec2f32{-0.5f, 5.f}));
+        test_check(!region.contains(vec2f32{5.f, -0.5f}));
+
+        // Second band: span [0, 30) in [10, 20)
+        test_check( region.contains(vec2f32{15.f, 10.f}));
+        test_check(!region.contains(vec2f32{15.f, 9.5f}));
+        test_check(!region.contains(vec2f32{15.f, 20.f}));
+        test_check(!region.contains(vec2f32{30.f, 15.f}));
+
+        test_check( region.contains(vec2f64{20.0, 0.0}));
+        test_check(!region.contains(vec2f64{10.0, 0.0}));
+
+        // Boxes may touch the far edges, and need every band to cover them
+        test_check( region.contains(aabb2f32{{0.f, 0.f}, {10.f, 20.f}, minmax}));
+        test_check(!region.contains(aabb2f32{{0.f, 0.f}, {11.f, 20.f}, minmax}));
+        test_check(!region.contains(aabb2f32{{0.f, 0.f}, {10.f, 21.f}, minmax}));
+        test_check( region.contains(aabb2f32{{5.f, 12.f}, {25.f, 18.f}, minmax}));
+        test_check(!region.contains(aabb2f32{{5.f,  5.f}, {25.f, 15.f}, minmax}));
+    };
+
+    region2f32 region;
+    region.add(aabb2f32{{ 0.f, 0.f}, {10.f, 10.f}, minmax});
+    region.add(aabb2f32{{20.f, 0.f}, {30.f, 10.f}, minmax});
+    region.add(aabb2f32{{ 0.f, 10.f}, {30.f, 20.f}, minmax});
+    check(region, false);
+
+    // Enough separate bands below to force the binary search
+    for (u32 i = 0; i < region_scan_max; ++i) {
+        region.add(aabb2f32{{0.f, 30.f + i * 10}, {f32(i + 1), 35.f + i * 10}, minmax});
+    }
+    check(region, true);
+}
+
+// The implementation before regions were banded, kept as a reference
+template<typename T, typename T2>
+static
+auto constrain_reference(const Region<T>& region, Vec<2, T2> point) -> Vec<2, T2>
+{
+    f64 closest_dist = INFINITY;
+    Vec<2, T2> closest = {};
+
+    for (auto aabb : region.aabbs) {
+        auto pos = aabb_clamp_point(aabb_cast<T2>(aabb), point);
+        if (pos == point) return point;
+
+        f64 dist = vec_distance(vec_cast<f64>(pos), vec_cast<f64>(point));
+        if (dist < closest_dist) {
+            closest = pos;
+            closest_dist = dist;
+        }
+    }
+
+    return closest;
+}
+
+static
+void test_constrain()
+{
+    std::minstd_rand rng(2);
+    std::uniform_real_distribution<f32> pos(-50.f, 550.f);
+    std::uniform_real_distribution<f32> size(1.f, 120.f);
+
+    // Several boxes can be equally close, and the batched search compares distances in f32,
+    // so results are compared by distance
+    auto check = [](auto& region, auto point) {
+        auto result = region.constrain(point);
+        auto expected = constrain_reference(region, point);
+        auto distance = [&](auto p) { return vec_distance(vec_cast<f64>(p), vec_cast<f64>(point)); };
+        test_check(std::abs(distance(result) - distance(expected)) <= 1e-3 * std::max(1.0, distance(expected)));
+        test_check(std::ranges::any_of(region.aabbs, [&](auto& aabb) {
+            return aabb_clamp_point(aabb_cast<decltype(point.x)>(aabb), result) == result;
+        }));
+    };
+
+    for (u32 count : {1, 3, 4, 7, 40}) {
+        region2f32 region;
+        region2i32 pixels;
+        for (u32 i = 0; i < count; ++i) {
+            aabb2f32 aabb = {{pos(rng), pos(rng)}, {size(rng), size(rng)}, xywh};
+            region.add(aabb);
+            pixels.add(aabb2i32{vec_cast<i32>(aabb.min), vec_cast<i32>(aabb.max), minmax});
+        }
+
+        for (u32 i = 0; i < 256; ++i) {
+            vec2f32 point = {pos(rng), pos(rng)};
+            check(region, point);
+            check(pixels, point);
+        }
+
+        // Points on the far edges are outside the half-open region, but constrain to themselves
+        for (auto& aabb : region.aabbs) {
+            test_check(region.constrain(aabb.max) == aabb.max);
+        }
+    }
+
+    test_check(region2f32{}.constrain(vec2f32{5.f, 5.f}) == vec2f32{});
+}
+
+void test_region()
+{
+    test_canonical_form();
+    test_coalescing();
+    test_empty();
+    test_contains_edges();
+    test_constrain();
+}
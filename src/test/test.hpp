@@ -0,0 +1,20 @@
+#pragma once
+
+#include <core/log.hpp>
+#include <core/types.hpp>
+
+// Number of failed checks so far, returned from `main` as the exit status
+inline u32 test_failures = 0;
+
+inline
+void test_fail(std::string_view expr, std::source_location location = std::source_location::current())
+{
+    log_error("{}:{}: check failed: {}", location.file_name(), location.line(), expr);
+    test_failures++;
+}
+
+// Unlike `debug_assert`, failures are recorded and the test carries on
+#define test_check(Expr) \
+    (static_cast<bool>(Expr) ? void() : test_fail(#Expr))
+
+void test_region();
@@ -11,28 +11,27 @@ auto WayBuffer::acquire(WaySurface* surface, WaySurfaceState* pending) -> Ref<Gp
     if (!pending->buffer) return nullptr;
 
     if (pending->surface.damage) {
-        auto bounds = pending->surface.damage.bounds();
-
         // Apply buffer transform
         auto transform = pending->set.contains(WaySurfaceStateComponent::buffer_transform)
             ? pending->buffer_transform
             : surface->current.buffer_transform;
         debug_assert(transform == WL_OUTPUT_TRANSFORM_NORMAL, "TODO: Support buffer transforms");
 
-        // Apply buffer scale
-        bounds.min *= pending->buffer_scale;
-        bounds.max *= pending->buffer_scale;
+        for (auto bounds : pending->surface.damage.boxes()) {
+            // Apply buffer scale
+            bounds.min *= pending->buffer_scale;
+            bounds.max *= pending->buffer_scale;
 
-        pending->buffer_damage.damage(bounds);
+            pending->buffer_damage.damage(bounds);
+        }
         pending->surface.damage.clear();
     }
 
     Flags<WayBufferAcquireFlags> flags = {};
 
-    // Wait for acquire
+    // The surface defers applying state until the acquire point signals, so the buffer is ready by now
 
     if (pending->acquire_point.syncobj) {
-        gpu_wait({pending->acquire_point.syncobj.get(), pending->acquire_point.value});
         flags |= WayBufferAcquireFlags::wait_handled;
     }
 
@@ -46,11 +45,34 @@ auto WayBuffer::acquire(WaySurface* surface, WaySurfaceState* pending) -> Ref<Gp
     return pending->buffer->do_acquire(surface, pending->buffer_damage, flags);
 }
 
-void WayBuffer::release()
+void WayBuffer::release(GpuSyncpoint last_use)
 {
-    if (release_point.syncobj) {
-        gpu_syncobj_signal_value(release_point.syncobj.get(), release_point.value);
-    } else {
-        way_send<wl_buffer_send_release>(_resource);
+    auto point = std::move(release_point);
+
+    bool pending = last_use.syncobj
+        && gpu_syncobj_get_value(last_use.syncobj) < last_use.value;
+
+    if (!pending) {
+        if (point.syncobj) {
+            gpu_syncobj_signal_value(point.syncobj.get(), point.value);
+        } else {
+            way_send<wl_buffer_send_release>(_resource);
+        }
+        return;
     }
+
+    // Explicit sync clients can wait on the GPU work directly
+
+    if (point.syncobj && last_use.value <= last_use.syncobj->gpu->queue.submitted) {
+        gpu_syncobj_transfer(point.syncobj.get(), point.value, last_use);
+        return;
+    }
+
+    gpu_wait(last_use, [buffer = Weak(this), point = std::move(point)](u64) {
+        if (point.syncobj) {
+            gpu_syncobj_signal_value(point.syncobj.get(), point.value);
+        } else if (buffer) {
+            way_send<wl_buffer_send_release>(buffer->_resource);
+        }
+    });
 }
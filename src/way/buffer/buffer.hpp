@@ -27,7 +27,9 @@ struct WayBuffer
     [[nodiscard]] virtual auto do_acquire(WaySurface*, WayDamageRegion, Flags<WayBufferAcquireFlags>) -> Ref<GpuImage> = 0;
 
     auto acquire(WaySurface*, WaySurfaceState* pending) -> Ref<GpuImage>;
-    void release();
+
+    // Releases the buffer back to the client once `last_use` has been reached
+    void release(GpuSyncpoint last_use = {});
 
 protected:
     ~WayBuffer() = default;
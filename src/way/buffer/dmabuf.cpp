@@ -313,9 +313,9 @@ auto WayDmaBuffer::do_acquire(WaySurface* surface, WayDamageRegion, Flags<WayBuf
         }
     }
 
-    return gpu_lease_image(image.get(), [buffer = Weak(this)](Ref<GpuImage>) {
+    return gpu_lease_image(image.get(), [buffer = Weak(this)](Ref<GpuImage> image) {
         if (buffer) {
-            buffer->release();
+            buffer->release(image->last_use());
         }
     });
 }
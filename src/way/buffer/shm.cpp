@@ -170,8 +170,8 @@ auto WayShmBuffer::do_acquire(WaySurface* surface, WayDamageRegion damage, Flags
 
     damage.clip_to({{}, vec_cast<i32>(extent), minmax});
 
-    if (damage) {
-        aabb2i32 aabb = damage.bounds();
+    // Each damaged box is uploaded separately, so that distant updates don't copy everything between them
+    for (auto& aabb : damage.boxes()) {
         rect2i32 rect = aabb;
 #if NOISY_SHM_BUFFER_IMAGES
         log_trace("  damage {}", rect);
@@ -190,11 +190,14 @@ auto WayShmBuffer::do_acquire(WaySurface* surface, WayDamageRegion damage, Flags
             }}});
     }
 #if NOISY_SHM_BUFFER_IMAGES
-    else {
+    if (!damage) {
         log_warn("  damage was empty");
     }
 #endif
 
+    // Start copying now, instead of waiting for the next frame to be submitted
+    gpu_flush_uploads(server->gpu);
+
     release();
 
     return image;
@@ -0,0 +1,69 @@
+#include "surface.hpp"
+
+struct WayBlur
+{
+    Weak<WaySurface> surface;
+    WayResource resource;
+
+    // A null region blurs the whole surface
+    region2f32 region = {way_infinite_aabb};
+};
+
+static
+void set_blur(WaySurface* surface, region2f32 region)
+{
+    surface->pending->set |= WaySurfaceStateComponent::blur_region;
+    surface->pending->blur_region = std::move(region);
+}
+
+static
+void create(wl_client* client, wl_resource* resource, u32 id, wl_resource* surface)
+{
+    auto blur = ref_create<WayBlur>();
+    blur->surface = way_get_userdata<WaySurface>(surface);
+    blur->resource = way_resource_create_refcounted(org_kde_kwin_blur, client, resource, id, blur.get());
+}
+
+static
+void unset(wl_client* client, wl_resource* resource, wl_resource* surface)
+{
+    set_blur(way_get_userdata<WaySurface>(surface), {});
+}
+
+WAY_INTERFACE(org_kde_kwin_blur_manager) = {
+    .create = create,
+    .unset = unset,
+};
+
+WAY_BIND_GLOBAL(org_kde_kwin_blur_manager, bind)
+{
+    way_resource_create_unsafe(org_kde_kwin_blur_manager, bind.client, bind.version, bind.id, bind.server);
+}
+
+// -----------------------------------------------------------------------------
+
+static
+void commit(wl_client* client, wl_resource* resource)
+{
+    auto* blur = way_get_userdata<WayBlur>(resource);
+    if (!blur->surface) return;
+
+    // Applied with the surface's next commit
+    set_blur(blur->surface.get(), blur->region);
+}
+
+static
+void set_region(wl_client* client, wl_resource* resource, wl_resource* region)
+{
+    auto* blur = way_get_userdata<WayBlur>(resource);
+
+    blur->region = region
+        ? way_get_userdata<WayRegion>(region)->region
+        : region2f32{way_infinite_aabb};
+}
+
+WAY_INTERFACE(org_kde_kwin_blur) = {
+    .commit = commit,
+    .set_region = set_region,
+    .release = way_simple_destroy,
+};
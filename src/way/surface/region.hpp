@@ -21,43 +21,108 @@ struct WayRegion
  *
  * Accurate damage is not required for correctness, as reading from un-damaged parts of a buffer is valid.
  *
- * Taking advantage of this, and the fact that damage is usually localized, we only
- * track the outer bounds of accumulated damage. This avoids relatively expensive region operations,
- * and reduces the number of copies on transfer and clip regions during rendering; while remaining
- * optimal or near optimal for all realistic scenarios.
+ * Taking advantage of this, damage is tracked as a small number of possibly overlapping boxes. New damage
+ * is merged into an existing box when that adds little undamaged area, so that nearby updates collapse
+ * into one copy while distant updates (e.g. a clock and a text caret) are kept apart. Once all boxes are
+ * in use, the pair that wastes the least area when merged is combined.
  */
+static constexpr u32 way_damage_rects_max = 4;
+
+// Damage is clipped to this distance from the origin, as clients commonly damage (0, 0, INT32_MAX, INT32_MAX)
+static constexpr i32 way_damage_coord_max = 1 << 24;
+
 struct WayDamageRegion
 {
-    static constexpr aabb2i32 Empty = {{INT_MAX, INT_MAX}, {INT_MIN, INT_MIN}, minmax};
-
 private:
-    aabb2i32 region = Empty;
+    std::array<aabb2i32, way_damage_rects_max + 1> rects;
+    u32 count = 0;
+
+    static auto area(const aabb2i32& aabb) -> i64
+    {
+        return (i64(aabb.max.x) - i64(aabb.min.x)) * (i64(aabb.max.y) - i64(aabb.min.y));
+    }
+
+    // Area of the merged box that neither input covers, ignoring overlap between them
+    static auto merge_cost(const aabb2i32& a, const aabb2i32& b) -> i64
+    {
+        return area(aabb_outer(a, b)) - area(a) - area(b);
+    }
+
+    void remove(u32 i)
+    {
+        rects[i] = rects[--count];
+    }
 
 public:
+    // Converts a protocol rect, whose far edge may not fit in an i32
+    static auto from_xywh(i32 x, i32 y, i32 width, i32 height) -> aabb2i32
+    {
+        auto clamp = [](i64 v) { return i32(std::clamp<i64>(v, -way_damage_coord_max, way_damage_coord_max)); };
+        return {{clamp(x), clamp(y)}, {clamp(i64(x) + width), clamp(i64(y) + height)}, minmax};
+    }
+
     void damage(aabb2i32 damage)
     {
-        region = aabb_outer(region, damage);
+        aabb2i32 limit = {{-way_damage_coord_max, -way_damage_coord_max}, {way_damage_coord_max, way_damage_coord_max}, minmax};
+        damage = aabb_inner(damage, limit);
+        if (damage.max.x <= damage.min.x || damage.max.y <= damage.min.y) return;
+
+        // Merge while the merged box wastes at most a quarter of its area
+        for (u32 i = 0; i < count; ++i) {
+            if (merge_cost(rects[i], damage) <= area(aabb_outer(rects[i], damage)) / 4) {
+                damage = aabb_outer(rects[i], damage);
+                remove(i);
+                i = -1u; // The grown box may now absorb others
+            }
+        }
+
+        rects[count++] = damage;
+        if (count <= way_damage_rects_max) return;
+
+        u32 best_a = 0, best_b = 1;
+        i64 best_cost = INT64_MAX;
+        for (u32 a = 0; a < count; ++a) {
+            for (u32 b = a + 1; b < count; ++b) {
+                if (auto cost = merge_cost(rects[a], rects[b]); cost < best_cost) {
+                    best_a = a;
+                    best_b = b;
+                    best_cost = cost;
+                }
+            }
+        }
+        rects[best_a] = aabb_outer(rects[best_a], rects[best_b]);
+        remove(best_b);
     }
 
     void clip_to(aabb2i32 limit)
     {
-        region = aabb_inner(region, limit);
+        for (u32 i = 0; i < count;) {
+            rects[i] = aabb_inner(rects[i], limit);
+            if (rects[i].max.x <= rects[i].min.x || rects[i].max.y <= rects[i].min.y) remove(i);
+            else ++i;
+        }
     }
 
     void clear()
     {
-        region = Empty;
+        count = 0;
     }
 
     explicit operator bool() const
     {
-        return region.max.x > region.min.x
-            && region.max.y > region.min.y;
+        return count;
+    }
+
+    auto boxes() const -> std::span<const aabb2i32>
+    {
+        return {rects.data(), count};
     }
 
-    auto bounds() -> aabb2i32
+    auto bounds() const -> aabb2i32
     {
         debug_assert(*this);
-        return region;
+        auto bounds = rects[0];
+        for (auto& rect : boxes()) bounds = aabb_outer(bounds, rect);
+        return bounds;
     }
 };
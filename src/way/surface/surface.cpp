@@ -91,7 +91,7 @@ void damage(wl_client* client, wl_resource* resource, i32 x, i32 y, i32 width, i
 {
     auto* surface = way_get_userdata<WaySurface>(resource);
 
-    surface->pending->surface.damage.damage({{x, y}, {width, height}, xywh});
+    surface->pending->surface.damage.damage(WayDamageRegion::from_xywh(x, y, width, height));
 }
 
 static
@@ -99,7 +99,7 @@ void damage_buffer(wl_client* client, wl_resource* resource, i32 x, i32 y, i32 w
 {
     auto* surface = way_get_userdata<WaySurface>(resource);
 
-    surface->pending->buffer_damage.damage({{x, y}, {width, height}, xywh});
+    surface->pending->buffer_damage.damage(WayDamageRegion::from_xywh(x, y, width, height));
 }
 
 static
@@ -133,6 +133,18 @@ void way_surface_on_redraw(WaySurface* surface)
     way_client_queue_flush(surface->client);
 }
 
+static
+void set_opaque_region(wl_client* client, wl_resource* resource, wl_resource* region)
+{
+    auto* surface = way_get_userdata<WaySurface>(resource);
+    auto* pending = surface->pending.get();
+
+    pending->set |= WaySurfaceStateComponent::opaque_region;
+    pending->surface.opaque_region = region
+        ? way_get_userdata<WayRegion>(region)->region
+        : region2f32{};
+}
+
 static
 void set_input_region(wl_client* client, wl_resource* resource, wl_resource* region)
 {
@@ -212,8 +224,8 @@ void apply(WaySurface* surface, WaySurfaceState& from)
                 surface->client->server->sampler.get(),
                 GpuBlendMode::premultiplied);
 
-            if (from.buffer_damage) {
-                scene_texture_damage(surface->scene.texture.get(), from.buffer_damage.bounds());
+            for (auto& damage : from.buffer_damage.boxes()) {
+                scene_texture_damage(surface->scene.texture.get(), damage);
             }
         } else {
             to.set -= WaySurfaceStateComponent::buffer;
@@ -227,6 +239,18 @@ void apply(WaySurface* surface, WaySurfaceState& from)
 
     way_viewport_apply(surface, from);
 
+    // Opaque region
+
+    if (from.set.contains(WaySurfaceStateComponent::opaque_region)) {
+        scene_texture_set_opaque(surface->scene.texture.get(), std::move(from.surface.opaque_region));
+    }
+
+    // Blur region
+
+    if (from.set.contains(WaySurfaceStateComponent::blur_region)) {
+        scene_texture_set_blur(surface->scene.texture.get(), std::move(from.blur_region));
+    }
+
     // Input regions
 
     if (from.set.contains(WaySurfaceStateComponent::input_region)) {
@@ -252,6 +276,28 @@ WaySurfaceAddon::~WaySurfaceAddon()
     std::erase(surface->addons, this);
 }
 
+static
+void flush(WaySurface* surface);
+
+static
+auto is_acquire_ready(WaySurface* surface, WaySurfaceState& packet) -> bool
+{
+    auto& point = packet.acquire_point;
+    if (!point.syncobj) return true;
+
+    if (gpu_syncobj_get_value(point.syncobj.get()) >= point.value) return true;
+
+    // Defer application until the acquire point is signalled, instead of blocking other clients
+
+    if (!std::exchange(packet.acquire_waiting, true)) {
+        gpu_wait({point.syncobj.get(), point.value}, [surface = Weak(surface)](u64) {
+            if (surface) flush(surface.get());
+        });
+    }
+
+    return false;
+}
+
 static
 void flush(WaySurface* surface)
 {
@@ -268,6 +314,10 @@ void flush(WaySurface* surface)
             break;
         }
 
+        if (!is_acquire_ready(surface, packet)) {
+            break;
+        }
+
         // Check for buffer ready
 
         if (packet.buffer && !(packet.image = packet.buffer->acquire(surface, &packet))) {
@@ -286,7 +336,7 @@ void flush(WaySurface* surface)
     auto* server = surface->client->server;
 
     for (auto* child : surface->scene.tree->children) {
-        auto* tree = dynamic_cast<SceneTree*>(child);
+        auto* tree = scene_node_cast<SceneTree>(child);
         if (!tree) continue;
         if (tree->userdata.id != server->userdata_id) continue;
         flush(way_get_userdata<WaySurface>(server, tree->userdata.data));
@@ -328,7 +378,7 @@ WAY_INTERFACE(wl_surface) = {
     .attach = attach,
     .damage = damage,
     .frame = frame,
-    WAY_STUB_QUIET(set_opaque_region),
+    .set_opaque_region = set_opaque_region,
     .set_input_region = set_input_region,
     .commit = commit,
     .set_buffer_transform = [](wl_client* client, wl_resource* resource, i32 bt) {
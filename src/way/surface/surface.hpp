@@ -11,6 +11,7 @@
 #include <wayland/server/xdg-decoration-unstable-v1.h>
 #include <wayland/server/linux-drm-syncobj-v1.h>
 #include <wayland/server/server-decoration.h>
+#include <wayland/server/blur.h>
 
 struct WaySurface;
 struct WayClient;
@@ -52,6 +53,9 @@ enum class WaySurfaceStateComponent : u32
     // wp_viewport
     buffer_source      = 1 << 5,
     buffer_destination = 1 << 6,
+
+    // org_kde_kwin_blur
+    blur_region = 1 << 7,
 };
 
 struct WayPositioner;
@@ -79,9 +83,11 @@ struct WaySurfaceState
     rect2f32            buffer_source;
     vec2i32             buffer_destination;
     WayDamageRegion     buffer_damage;
+    region2f32          blur_region;
 
     WayTimelinePoint acquire_point;
     WayTimelinePoint release_point;
+    bool             acquire_waiting;
 
     ~WaySurfaceState();
 };
@@ -203,6 +209,9 @@ WAY_INTERFACE_DECLARE(zxdg_toplevel_decoration_v1);
 WAY_INTERFACE_DECLARE(org_kde_kwin_server_decoration_manager, 1);
 WAY_INTERFACE_DECLARE(org_kde_kwin_server_decoration);
 
+WAY_INTERFACE_DECLARE(org_kde_kwin_blur_manager, 1);
+WAY_INTERFACE_DECLARE(org_kde_kwin_blur);
+
 WAY_INTERFACE_DECLARE(wp_linux_drm_syncobj_manager_v1, 1);
 WAY_INTERFACE_DECLARE(wp_linux_drm_syncobj_timeline_v1);
 WAY_INTERFACE_DECLARE(wp_linux_drm_syncobj_surface_v1);
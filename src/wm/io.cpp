@@ -117,6 +117,14 @@ auto wm_output_get_viewport(WmOutput* output) -> rect2f32
     return output->viewport;
 }
 
+auto wm_output_get_fullscreen_window(WmOutput* output) -> WmWindow*
+{
+    for (auto* window : output->server->windows) {
+        if (wm_window_get_fullscreen(window) == output) return window;
+    }
+    return nullptr;
+}
+
 void wm_request_frame(WmServer* wm)
 {
     for (auto* output : wm->io.outputs) {
@@ -288,11 +296,14 @@ void handle_input_region_damage(WmServer* wm)
 static
 void handle_damage(WmServer* wm, SceneNode* node)
 {
-    for (auto* output : wm->io.outputs) {
-        output->interface.request_frame(output->userdata);
+    // Nodes under disabled trees (e.g. a cursor shown on a hardware plane) don't affect output contents
+    if (scene_node_is_visible(node)) {
+        for (auto* output : wm->io.outputs) {
+            output->interface.request_frame(output->userdata);
+        }
     }
 
-    if (dynamic_cast<SceneInputRegion*>(node)) {
+    if (scene_node_cast<SceneInputRegion>(node)) {
         wm->handle_input_region_damage = wm->exec->idle.listen([wm] {
             wm->handle_input_region_damage.unlink();
             handle_input_region_damage(wm);
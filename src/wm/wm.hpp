@@ -191,6 +191,7 @@ void wm_request_frame(WmServer*);
 auto wm_list_outputs(WmServer*) -> std::span<WmOutput* const>;
 
 auto wm_output_get_viewport(WmOutput*) -> rect2f32;
+auto wm_output_get_fullscreen_window(WmOutput*) -> WmWindow*;
 
 struct WmFindOutputResult
 {